@@ -0,0 +1,110 @@
+/*
+SRC-Link
+Copyright (C) 2024 OPENSPHERE Inc. info@opensphere.co.jp
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+// Microbenchmark of mixAudioClamped() kernels against the former per-sample loop of OutputAudioSource::popAudio.
+// Every kernel must produce bit-exact results, otherwise exits with non-zero status.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "../src/outputs/audio-mix.hpp"
+
+#define BENCH_FRAMES 1024 // AUDIO_OUTPUT_FRAMES
+#define BENCH_INPUTS 16 // e.g. 8 outputs x stereo
+#define BENCH_ITERATIONS 20000
+#define BENCH_MAX_KERNELS 4
+
+// The former loop with two branches per sample
+static void mixLegacy(float *out, const float *in, size_t frames)
+{
+    for (size_t i = 0; i < frames; i++) {
+        *out += *(in++);
+        if (*out > 1.0f) {
+            *out = 1.0f;
+        } else if (*out < -1.0f) {
+            *out = -1.0f;
+        }
+        out++;
+    }
+}
+
+static double run(AudioMixKernel kernel, const std::vector<std::vector<float>> &inputs, std::vector<float> &out)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int n = 0; n < BENCH_ITERATIONS; n++) {
+        std::fill(out.begin(), out.end(), 0.0f);
+        for (const auto &in : inputs) {
+            kernel(out.data(), in.data(), out.size());
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / BENCH_ITERATIONS;
+}
+
+int main()
+{
+    // Sums of many inputs exceed 1.0 so that both clamp sides are exercised
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<float> dist(-0.75f, 0.75f);
+    std::vector<std::vector<float>> inputs(BENCH_INPUTS, std::vector<float>(BENCH_FRAMES));
+    for (auto &in : inputs) {
+        for (auto &sample : in) {
+            sample = dist(rng);
+        }
+    }
+
+    // Odd length to cover the scalar tail of vector kernels as well
+    const size_t tailFrames = BENCH_FRAMES - 3;
+
+    std::vector<float> expected(BENCH_FRAMES);
+    auto legacyNsecs = run(mixLegacy, inputs, expected);
+    std::vector<float> expectedTail(tailFrames, 0.0f);
+    for (const auto &in : inputs) {
+        mixLegacy(expectedTail.data(), in.data(), tailFrames);
+    }
+
+    printf("%-8s %10.1f ns/mix %6.2fx\n", "legacy", legacyNsecs, 1.0);
+
+    AudioMixKernelEntry kernels[BENCH_MAX_KERNELS];
+    auto count = getAudioMixKernels(kernels, BENCH_MAX_KERNELS);
+    auto failed = false;
+
+    for (size_t k = 0; k < count; k++) {
+        std::vector<float> out(BENCH_FRAMES);
+        auto nsecs = run(kernels[k].kernel, inputs, out);
+
+        std::vector<float> outTail(tailFrames, 0.0f);
+        for (const auto &in : inputs) {
+            kernels[k].kernel(outTail.data(), in.data(), tailFrames);
+        }
+
+        auto exact = !memcmp(out.data(), expected.data(), out.size() * sizeof(float)) &&
+                     !memcmp(outTail.data(), expectedTail.data(), outTail.size() * sizeof(float));
+        failed |= !exact;
+
+        printf(
+            "%-8s %10.1f ns/mix %6.2fx%s%s\n", kernels[k].name, nsecs, legacyNsecs / nsecs,
+            !strcmp(kernels[k].name, getAudioMixKernelName()) ? " (selected)" : "", exact ? "" : " MISMATCH"
+        );
+    }
+
+    return failed ? 1 : 0;
+}
@@ -67,8 +67,7 @@ EgressLinkConnectionWidget::EgressLinkConnectionWidget(
         SLOT(onRecordingStatusChanged(RecordingOutputStatus))
     );
     connect(
-        output, SIGNAL(statisticsUpdated(double, int, int, uint64_t)), this,
-        SLOT(onStatisticsUpdated(double, int, int, uint64_t))
+        output, SIGNAL(statisticsUpdated(const OutputMetric &)), this, SLOT(onStatisticsUpdated(const OutputMetric &))
     );
     connect(ui->settingsButton, SIGNAL(clicked()), this, SLOT(onSettingsButtonClick()));
     connect(ui->visibilityCheckBox, SIGNAL(clicked(bool)), this, SLOT(onVisibilityChanged(bool)));
@@ -262,12 +261,23 @@ void EgressLinkConnectionWidget::onVisibilityChanged(bool value)
     output->setVisible(value);
 }
 
-void EgressLinkConnectionWidget::onStatisticsUpdated(double bitrate, int totalFrames, int droppedFrames, uint64_t)
+void EgressLinkConnectionWidget::onStatisticsUpdated(const OutputMetric &metric)
 {
+    auto totalFrames = metric.getTotalFrames();
+    auto droppedFrames = metric.getDroppedFrames();
     ui->statsValueLabel->setText(
         QTStr("%1.kbps[drops.%2(%3%)]")
-            .arg(bitrate, 0, 'f', 0)
+            .arg(metric.getBitrate(), 0, 'f', 0)
             .arg(droppedFrames)
             .arg(totalFrames ? 100.0 * (double)droppedFrames / (double)totalFrames : 0.0, 0, 'f', 1)
     );
+    // Tell whether drops are network-bound or encode-bound
+    ui->statsValueLabel->setToolTip(
+        QTStr("StatisticsDetails")
+            .arg(metric.getCongestion() * 100.0, 0, 'f', 1)
+            .arg(metric.getSkippedFrames())
+            .arg(metric.getConnectTime())
+            .arg(metric.getActivationLatency(), 0, 'f', 0)
+            .arg(metric.getConfiguredKeyframeInterval())
+    );
 }
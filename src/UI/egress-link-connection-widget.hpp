@@ -53,7 +53,7 @@ private slots:
     void onRecordingStatusChanged(RecordingOutputStatus status);
     void updateSourceList();
     void onVisibilityChanged(bool value);
-    void onStatisticsUpdated(double bitrate, int totalFrames, int droppedFrames, uint64_t bytesSent);
+    void onStatisticsUpdated(const OutputMetric &metric);
 
 public:
     explicit EgressLinkConnectionWidget(
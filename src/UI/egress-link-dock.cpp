@@ -25,6 +25,15 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #include "egress-link-dock.hpp"
 #include "egress-link-connection-widget.hpp"
 
+// Display stage's names instead of party event
+static QString participantItemText(const PartyEventParticipant &participant)
+{
+    return participant.getOwnerAccountView().isEmpty() ? participant.getStageView().getName()
+                                                       : QString("%1 (%2)")
+                                                             .arg(participant.getStageView().getName())
+                                                             .arg(participant.getOwnerAccountView().getDisplayName());
+}
+
 //--- SouceLinkDock class ---//
 
 EgressLinkDock::EgressLinkDock(SRCLinkApiClient *_apiClient, QWidget *parent)
@@ -59,6 +68,9 @@ EgressLinkDock::EgressLinkDock(SRCLinkApiClient *_apiClient, QWidget *parent)
         apiClient, SIGNAL(participantsReady(const PartyEventParticipantArray &)), this,
         SLOT(onParticipantsReady(const PartyEventParticipantArray &))
     );
+    connect(apiClient, &SRCLinkApiClient::participantAdded, this, &EgressLinkDock::onParticipantAdded);
+    connect(apiClient, &SRCLinkApiClient::participantChanged, this, &EgressLinkDock::onParticipantChanged);
+    connect(apiClient, &SRCLinkApiClient::participantRemoved, this, &EgressLinkDock::onParticipantRemoved);
     connect(
         apiClient, SIGNAL(getPictureSucceeded(const QString &, const QImage &)), this,
         SLOT(onPictureReady(const QString &, const QImage &))
@@ -67,6 +79,7 @@ EgressLinkDock::EgressLinkDock(SRCLinkApiClient *_apiClient, QWidget *parent)
     connect(apiClient, SIGNAL(uplinkReady(const UplinkInfo &)), this, SLOT(onUplinkReady(const UplinkInfo &)));
     connect(apiClient, SIGNAL(uplinkFailed(const QString &)), this, SLOT(onUplinkFailed(const QString &)));
     connect(apiClient, SIGNAL(logoutSucceeded()), this, SLOT(onLogoutSucceeded()));
+    connect(apiClient, &SRCLinkApiClient::linkHealthUpdated, this, &EgressLinkDock::onLinkHealthUpdated);
     connect(
         apiClient, SIGNAL(putUplinkFailed(const QString &, QNetworkReply::NetworkError)), this,
         SLOT(onPutUplinkFailed(const QString &, QNetworkReply::NetworkError))
@@ -165,6 +178,24 @@ void EgressLinkDock::onAccountInfoReady(const AccountInfo &accountInfo)
     }
 }
 
+// Show RTT of the API server on the account name
+void EgressLinkDock::onLinkHealthUpdated(const LinkHealth &health)
+{
+    if (!health.samples) {
+        ui->accountNameLabel->setToolTip("");
+        return;
+    }
+
+    ui->accountNameLabel->setToolTip(
+        QTStr("LinkHealthDetails")
+            .arg(health.lastRtt)
+            .arg(health.minRtt)
+            .arg(health.avgRtt, 0, 'f', 1)
+            .arg(health.p99Rtt)
+            .arg(health.halfOpenCount)
+    );
+}
+
 void EgressLinkDock::onParticipantsReady(const PartyEventParticipantArray &participants)
 {
     auto prev = ui->participantComboBox->currentData().toString();
@@ -178,14 +209,7 @@ void EgressLinkDock::onParticipantsReady(const PartyEventParticipantArray &parti
         if (participants.size()) {
             ui->participantComboBox->addItem("", PARTICIPANT_SEELCTION_NONE); // No selection (id == "none")
             foreach (const auto &participant, participants.values()) {
-                ui->participantComboBox->addItem(
-                    participant.getOwnerAccountView().isEmpty()
-                        ? participant.getStageView().getName()
-                        : QString("%1 (%2)")
-                              .arg(participant.getStageView().getName())
-                              .arg(participant.getOwnerAccountView().getDisplayName()),
-                    participant.getId()
-                );
+                ui->participantComboBox->addItem(participantItemText(participant), participant.getId());
             }
         }
 
@@ -215,12 +239,75 @@ void EgressLinkDock::onParticipantsReady(const PartyEventParticipantArray &parti
     }
 }
 
+void EgressLinkDock::onParticipantAdded(const QString &id, const PartyEventParticipant &participant)
+{
+    auto prev = ui->participantComboBox->currentData().toString();
+
+    ui->participantComboBox->blockSignals(true);
+    {
+        if (!ui->participantComboBox->count()) {
+            ui->participantComboBox->addItem("", PARTICIPANT_SEELCTION_NONE); // No selection (id == "none")
+        }
+        ui->participantComboBox->addItem(participantItemText(participant), id);
+
+        // Restore selection when the saved participant appears
+        if ((prev.isEmpty() || prev == PARTICIPANT_SEELCTION_NONE) &&
+            id == apiClient->getSettings()->getParticipantId()) {
+            ui->participantComboBox->setCurrentIndex(ui->participantComboBox->count() - 1);
+        }
+    }
+    ui->participantComboBox->blockSignals(false);
+
+    if (ui->participantComboBox->currentData().toString() != prev) {
+        onActiveParticipantChanged(ui->participantComboBox->currentIndex());
+    }
+}
+
+void EgressLinkDock::onParticipantChanged(const QString &id, const PartyEventParticipant &participant)
+{
+    auto index = ui->participantComboBox->findData(id);
+    if (index < 0) {
+        onParticipantAdded(id, participant);
+        return;
+    }
+
+    ui->participantComboBox->setItemText(index, participantItemText(participant));
+
+    if (index == ui->participantComboBox->currentIndex()) {
+        // Stage picture may have been changed
+        onActiveParticipantChanged(index);
+    }
+}
+
+void EgressLinkDock::onParticipantRemoved(const QString &id)
+{
+    auto index = ui->participantComboBox->findData(id);
+    if (index < 0) {
+        return;
+    }
+    auto prev = ui->participantComboBox->currentData().toString();
+
+    ui->participantComboBox->blockSignals(true);
+    {
+        ui->participantComboBox->removeItem(index);
+        if (ui->participantComboBox->count() == 1) {
+            // Only "none" remains
+            ui->participantComboBox->clear();
+        } else if (prev == id) {
+            ui->participantComboBox->setCurrentIndex(0);
+        }
+    }
+    ui->participantComboBox->blockSignals(false);
+
+    if (ui->participantComboBox->currentData().toString() != prev) {
+        onActiveParticipantChanged(ui->participantComboBox->currentIndex());
+    }
+}
+
 void EgressLinkDock::onActiveParticipantChanged(int)
 {
     auto participantId = ui->participantComboBox->currentData().toString();
-    auto participant = apiClient->getParticipants().find([participantId](const PartyEventParticipant &_participant) {
-        return _participant.getId() == participantId;
-    });
+    auto participant = apiClient->getParticipant(participantId);
 
     // Apply default picture first
     ui->participantPictureLabel->setProperty("pictureId", "");
@@ -357,6 +444,8 @@ void EgressLinkDock::onInterlockTypeChanged(int)
 {
     auto interlockType = ui->interlockTypeComboBox->currentData().toString();
     apiClient->getSettings()->setValue("interlock_type", interlockType);
+    // Outputs react to the new interlock immediately
+    apiClient->refreshEgress();
 
     updateGuidance();
 }
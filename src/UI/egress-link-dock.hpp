@@ -50,6 +50,9 @@ class EgressLinkDock : public QFrame {
 private slots:
     void onAccountInfoReady(const AccountInfo &accountInfo);
     void onParticipantsReady(const PartyEventParticipantArray &participants);
+    void onParticipantAdded(const QString &id, const PartyEventParticipant &participant);
+    void onParticipantChanged(const QString &id, const PartyEventParticipant &participant);
+    void onParticipantRemoved(const QString &id);
     void onActiveParticipantChanged(int index);
     void onPictureReady(const QString &pictureId, const QImage &picture);
     void onPictureFailed(const QString &pictureId);
@@ -63,6 +66,7 @@ private slots:
     void onMembershipsButtonClicked();
     void onSignupButtonClicked();
     void onRedeemInviteCodeAccepted(const QString &inviteCode);
+    void onLinkHealthUpdated(const LinkHealth &health);
 
 public:
     explicit EgressLinkDock(SRCLinkApiClient *_apiClient, QWidget *parent = nullptr);
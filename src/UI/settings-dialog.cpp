@@ -104,6 +104,7 @@ SettingsDialog::SettingsDialog(SRCLinkApiClient *_apiClient, QWidget *parent)
     ui->guestCodeLabel->setText(QTStr("GuestCodeNotFound"));
     ui->manageGuestCodesButton->setText(QTStr("Manage"));
     ui->uplinkHwEncoderCheckBox->setText(QTStr("PreferHardwareEncoder"));
+    ui->uplinkPrewarmCheckBox->setText(QTStr("PrewarmStandBy"));
     setWindowTitle(QTStr("SourceLinkSettings"));
 
     // Read oss info markdown
@@ -215,7 +216,9 @@ void SettingsDialog::saveSettings()
                                 ingressPrivateIp != apiClient->getSettings()->getIngressPrivateIpValue();
 
     auto egressScreenshotInterval = ui->ssIntervalComboBox->currentData().toInt();
-    auto egressRefreshNeeded = egressScreenshotInterval != apiClient->getSettings()->getEgressScreenshotInterval();
+    auto egressPrewarmStandBy = ui->uplinkPrewarmCheckBox->isChecked();
+    auto egressRefreshNeeded = egressScreenshotInterval != apiClient->getSettings()->getEgressScreenshotInterval() ||
+                               egressPrewarmStandBy != apiClient->getSettings()->getEgressPrewarmStandBy();
 
     auto settings = apiClient->getSettings();
     settings->setIngressPortMin(ingressPortMin);
@@ -230,6 +233,7 @@ void SettingsDialog::saveSettings()
     settings->setIngressPrivateIpValue(ingressPrivateIp);
     settings->setEgressScreenshotInterval(egressScreenshotInterval);
     settings->setEgressPreferHardwareEncoder(ui->uplinkHwEncoderCheckBox->isChecked());
+    settings->setEgressPrewarmStandBy(egressPrewarmStandBy);
 
     apiClient->putUplink();
     if (ingressRefreshNeeded) {
@@ -253,6 +257,7 @@ void SettingsDialog::loadSettings()
     ui->advancedSettingsCheckBox->setChecked(settings->getIngressAdvancedSettings());
     ui->ssIntervalComboBox->setCurrentIndex(ui->ssIntervalComboBox->findData(settings->getEgressScreenshotInterval()));
     ui->uplinkHwEncoderCheckBox->setChecked(settings->getEgressPreferHardwareEncoder());
+    ui->uplinkPrewarmCheckBox->setChecked(settings->getEgressPrewarmStandBy());
 
     auto privateIpIndex = ui->privateIpComboBox->findData(settings->getIngressPrivateIpValue());
     if (privateIpIndex < 0) {
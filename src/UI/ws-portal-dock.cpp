@@ -26,6 +26,14 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #include "../utils.hpp"
 #include "ws-portal-dock.hpp"
 
+// Display portal's name with owner
+static QString wsPortalItemText(const WsPortal &portal)
+{
+    return portal.getOwnerAccountView().isEmpty()
+               ? portal.getName()
+               : QString("%1 (%2)").arg(portal.getName()).arg(portal.getOwnerAccountView().getDisplayName());
+}
+
 //--- WsPortalDock class ---//
 
 WsPortalDock::WsPortalDock(SRCLinkApiClient *_apiClient, QWidget *parent)
@@ -52,6 +60,9 @@ WsPortalDock::WsPortalDock(SRCLinkApiClient *_apiClient, QWidget *parent)
     connect(
         apiClient, SIGNAL(wsPortalsReady(const WsPortalArray &)), this, SLOT(onWsPortalsReady(const WsPortalArray &))
     );
+    connect(apiClient, &SRCLinkApiClient::wsPortalAdded, this, &WsPortalDock::onWsPortalAdded);
+    connect(apiClient, &SRCLinkApiClient::wsPortalChanged, this, &WsPortalDock::onWsPortalChanged);
+    connect(apiClient, &SRCLinkApiClient::wsPortalRemoved, this, &WsPortalDock::onWsPortalRemoved);
     connect(
         apiClient, SIGNAL(getPictureSucceeded(const QString &, const QImage &)), this,
         SLOT(onPictureReady(const QString &, const QImage &))
@@ -61,6 +72,7 @@ WsPortalDock::WsPortalDock(SRCLinkApiClient *_apiClient, QWidget *parent)
     connect(wsPortalClient, SIGNAL(connected()), this, SLOT(onConnected()));
     connect(wsPortalClient, SIGNAL(disconnected()), this, SLOT(onDisconnected()));
     connect(wsPortalClient, SIGNAL(reconnecting()), this, SLOT(onReconnecting()));
+    connect(wsPortalClient, &WsPortalClient::linkHealthUpdated, this, &WsPortalDock::onLinkHealthUpdated);
 
     connect(ui->connectionButton, SIGNAL(clicked()), this, SLOT(onConnectionButtonClicked()));
     connect(ui->wsPortalComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(onActiveWsPortalChanged(int)));
@@ -161,7 +173,7 @@ void WsPortalDock::updateGuidance()
 const WsPortal WsPortalDock::getActiveWsPortal() const
 {
     auto portalId = ui->wsPortalComboBox->currentData().toString();
-    return apiClient->getWsPortals().find([portalId](const WsPortal &_portal) { return _portal.getId() == portalId; });
+    return apiClient->getWsPortal(portalId);
 }
 
 void WsPortalDock::updateConnectionInfo()
@@ -287,12 +299,7 @@ void WsPortalDock::onWsPortalsReady(const WsPortalArray &portals)
         if (portals.size()) {
             ui->wsPortalComboBox->addItem("", PARTICIPANT_SEELCTION_NONE); // No selection (id == "none")
             foreach (const auto &portal, portals.values()) {
-                ui->wsPortalComboBox->addItem(
-                    portal.getOwnerAccountView().isEmpty()
-                        ? portal.getName()
-                        : QString("%1 (%2)").arg(portal.getName()).arg(portal.getOwnerAccountView().getDisplayName()),
-                    portal.getId()
-                );
+                ui->wsPortalComboBox->addItem(wsPortalItemText(portal), portal.getId());
             }
         }
 
@@ -321,6 +328,74 @@ void WsPortalDock::onWsPortalsReady(const WsPortalArray &portals)
     }
 }
 
+void WsPortalDock::onWsPortalAdded(const QString &id, const WsPortal &portal)
+{
+    auto prev = ui->wsPortalComboBox->currentData().toString();
+
+    ui->wsPortalComboBox->blockSignals(true);
+    {
+        if (!ui->wsPortalComboBox->count()) {
+            ui->wsPortalComboBox->addItem("", PARTICIPANT_SEELCTION_NONE); // No selection (id == "none")
+        }
+        ui->wsPortalComboBox->addItem(wsPortalItemText(portal), id);
+
+        // Restore selection when the saved portal appears
+        if (prev.isEmpty() && id == apiClient->getSettings()->getWsPortalId()) {
+            ui->wsPortalComboBox->setCurrentIndex(ui->wsPortalComboBox->count() - 1);
+        }
+    }
+    ui->wsPortalComboBox->blockSignals(false);
+
+    if (ui->wsPortalComboBox->currentData().toString() != prev) {
+        onActiveWsPortalChanged(ui->wsPortalComboBox->currentIndex());
+    } else {
+        updateGuidance();
+    }
+}
+
+void WsPortalDock::onWsPortalChanged(const QString &id, const WsPortal &portal)
+{
+    auto index = ui->wsPortalComboBox->findData(id);
+    if (index < 0) {
+        onWsPortalAdded(id, portal);
+        return;
+    }
+
+    ui->wsPortalComboBox->setItemText(index, wsPortalItemText(portal));
+
+    if (index == ui->wsPortalComboBox->currentIndex()) {
+        // Picture and connection info may have been changed
+        onActiveWsPortalChanged(index);
+    }
+}
+
+void WsPortalDock::onWsPortalRemoved(const QString &id)
+{
+    auto index = ui->wsPortalComboBox->findData(id);
+    if (index < 0) {
+        return;
+    }
+    auto prev = ui->wsPortalComboBox->currentData().toString();
+
+    ui->wsPortalComboBox->blockSignals(true);
+    {
+        ui->wsPortalComboBox->removeItem(index);
+        if (ui->wsPortalComboBox->count() == 1) {
+            // Only "none" remains
+            ui->wsPortalComboBox->clear();
+        } else if (prev == id) {
+            ui->wsPortalComboBox->setCurrentIndex(0);
+        }
+    }
+    ui->wsPortalComboBox->blockSignals(false);
+
+    if (ui->wsPortalComboBox->currentData().toString() != prev) {
+        onActiveWsPortalChanged(ui->wsPortalComboBox->currentIndex());
+    } else {
+        updateGuidance();
+    }
+}
+
 void WsPortalDock::onWsPortalsButtonClicked()
 {
     apiClient->openWsPortalsPage();
@@ -355,3 +430,21 @@ void WsPortalDock::onReconnecting()
     ui->guidanceLabel->setText(QTStr("Guidance.ReconnectingPortal"));
     setThemeID(ui->guidanceLabel, "error", "text-danger");
 }
+
+// Show RTT of the portal server on the status
+void WsPortalDock::onLinkHealthUpdated(const LinkHealth &health)
+{
+    if (!health.samples) {
+        ui->wsPortalStatus->setToolTip("");
+        return;
+    }
+
+    ui->wsPortalStatus->setToolTip(
+        QTStr("LinkHealthDetails")
+            .arg(health.lastRtt)
+            .arg(health.minRtt)
+            .arg(health.avgRtt, 0, 'f', 1)
+            .arg(health.p99Rtt)
+            .arg(health.halfOpenCount)
+    );
+}
@@ -50,11 +50,15 @@ private slots:
     void onPictureFailed(const QString &pictureId);
     void onActiveWsPortalChanged(int index);
     void onWsPortalsReady(const WsPortalArray &portals);
+    void onWsPortalAdded(const QString &id, const WsPortal &portal);
+    void onWsPortalChanged(const QString &id, const WsPortal &portal);
+    void onWsPortalRemoved(const QString &id);
     void onWsPortalsButtonClicked();
     void onControlPanelButtonClicked();
     void onConnected();
     void onDisconnected();
     void onReconnecting();
+    void onLinkHealthUpdated(const LinkHealth &health);
 
 public:
     explicit WsPortalDock(SRCLinkApiClient *_apiClient, QWidget *parent = nullptr);
@@ -29,7 +29,7 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #include <QPromise>
 #include <QTimer>
 #include <QByteArray>
-#include <QBuffer>
+#include <QIODevice>
 #include <QFile>
 
 #include <o0settingsstore.h>
@@ -42,10 +42,40 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 
 #define SCOPE "read write"
 #define SCREENSHOT_QUALITY 75
+#define SCREENSHOT_ENCODER_THREADS 2
+#define STATISTICS_FLUSH_INTERVAL_MSECS 5000
+// Servers announce the batch statistics in "ready", otherwise statistics are put per output
+#define WEBSOCKET_CAPABILITY_STATISTICS_BATCH "statistics.put_batch"
+#define WEBSOCKET_CHANGES_MAX_DELAY_MSECS 200
+#define WEBSOCKET_MAX_ITEM_SIGNALS 4
+// Requests for the same resource are invoked in order, others run in parallel
+#define RESOURCE_KEY_ACCOUNT "account"
+#define RESOURCE_KEY_PARTIES "parties"
+#define RESOURCE_KEY_PARTY_EVENTS "party_events"
+#define RESOURCE_KEY_PARTICIPANTS "participants"
+#define RESOURCE_KEY_STAGES "stages"
+#define RESOURCE_KEY_UPLINK "uplink"
+#define RESOURCE_KEY_DOWNLINK "downlink:%1"
 #define REPLY_HTML_NAME "oauth-reply.html"
 
 //#define API_DEBUG
 
+// Write-only device which appends into std::vector (Avoids copying encoded data)
+class VectorWriteDevice : public QIODevice {
+    std::vector<uint8_t> &buffer;
+
+public:
+    explicit VectorWriteDevice(std::vector<uint8_t> &_buffer) : buffer(_buffer) { open(QIODevice::WriteOnly); }
+
+protected:
+    qint64 readData(char *, qint64) override { return -1; }
+    qint64 writeData(const char *data, qint64 len) override
+    {
+        buffer.insert(buffer.end(), data, data + len);
+        return len;
+    }
+};
+
 // REST Endpoints
 #ifndef API_SERVER
 #define API_SERVER "http://localhost:3000"
@@ -127,7 +157,11 @@ SRCLinkApiClient::SRCLinkApiClient(QObject *parent)
       activeOutputs(0),
       standByOutputs(0),
       uplinkStatus(UPLINK_STATUS_INACTIVE),
-      terminating(false)
+      terminating(false),
+      readyStartedAt(QDateTime::currentMSecsSinceEpoch()),
+      uplinkChanged(false),
+      accountInfoChanged(false),
+      licenseValidityChanged(false)
 {
     API_LOG("SRCLinkApiClient creating with %s,%s,%s", API_SERVER, API_WS_SERVER, FRONTEND_SERVER);
 
@@ -135,6 +169,18 @@ SRCLinkApiClient::SRCLinkApiClient(QObject *parent)
     client = new O2(this, networkManager, settings);
     sequencer = new RequestSequencer(networkManager, client, this);
     websocket = new SRCLinkWebSocketClient(QUrl(WEBSOCKET_URL), this, this);
+    screenshotPool = new QThreadPool(this);
+    screenshotPool->setMaxThreadCount(SCREENSHOT_ENCODER_THREADS);
+
+    // Statistics of all outputs are uploaded in one message
+    statisticsFlushTimer = new QTimer(this);
+    statisticsFlushTimer->setInterval(STATISTICS_FLUSH_INTERVAL_MSECS);
+    statisticsFlushTimer->start();
+    connect(statisticsFlushTimer, &QTimer::timeout, this, &SRCLinkApiClient::flushStatistics);
+
+    webSocketChangesTimer = new QTimer(this);
+    webSocketChangesTimer->setSingleShot(true);
+    connect(webSocketChangesTimer, &QTimer::timeout, this, &SRCLinkApiClient::emitWebSocketChanges);
 
     uuid = settings->value("uuid");
     if (uuid.isEmpty()) {
@@ -214,6 +260,10 @@ SRCLinkApiClient::SRCLinkApiClient(QObject *parent)
         websocket, &SRCLinkWebSocketClient::invokeFailed, this,
         [this](const QString &name, const QJsonObject &payload) { emit webSocketInvokeFailed(name, payload); }
     );
+    connect(
+        websocket->getHealthMonitor(), &LinkHealthMonitor::healthUpdated, this,
+        [this](const LinkHealth &health) { emit linkHealthUpdated(health); }
+    );
 
     connect(this, &SRCLinkApiClient::licenseChanged, [this](const SubscriptionLicense &license) {
         if (license.getLicenseValid()) {
@@ -250,6 +300,9 @@ SRCLinkApiClient::SRCLinkApiClient(QObject *parent)
 
 SRCLinkApiClient::~SRCLinkApiClient()
 {
+    // Pending results are discarded with this object
+    screenshotPool->waitForDone();
+
     API_LOG("SRCLinkApiClient destroyed");
 }
 
@@ -312,13 +365,23 @@ void SRCLinkApiClient::clearOnlineResources()
     accountInfo = AccountInfo();
     parties = PartyArray();
     partyEvents = PartyEventArray();
-    participants = PartyEventParticipantArray();
-    stages = StageArray();
+    participants.clear();
+    stages.clear();
     uplink = UplinkInfo();
-    wsPortals = WsPortalArray();
+    wsPortals.clear();
     downlinks.clear();
     settings->setParticipantId("");
     settings->setPartyId("");
+
+    // Drop pending WebSocket changes of the cleared session
+    webSocketChangesTimer->stop();
+    uplinkChanged = false;
+    accountInfoChanged = false;
+    licenseValidityChanged = false;
+    downlinkChanges.clear();
+    stageChanges.clear();
+    participantChanges.clear();
+    wsPortalChanges.clear();
 }
 
 void SRCLinkApiClient::terminate()
@@ -364,7 +427,7 @@ const RequestInvoker *SRCLinkApiClient::requestAccountInfo()
     CHECK_CLIENT_TOKEN(nullptr);
 
     API_LOG("Requesting account info.");
-    auto invoker = new RequestInvoker(sequencer, this);
+    auto invoker = new RequestInvoker(sequencer, RESOURCE_KEY_ACCOUNT, this);
     connect(invoker, &RequestInvoker::finished, this, [this](QNetworkReply::NetworkError error, QByteArray replyData) {
         CHECK_RESPONSE_NOERROR(accountInfoFailed, "Requesting account info failed: %d", error);
 
@@ -398,7 +461,7 @@ const RequestInvoker *SRCLinkApiClient::requestParties()
     CHECK_CLIENT_TOKEN(nullptr);
 
     API_LOG("Requesting parties.");
-    auto invoker = new RequestInvoker(sequencer, this);
+    auto invoker = new RequestInvoker(sequencer, RESOURCE_KEY_PARTIES, this);
     connect(invoker, &RequestInvoker::finished, [this](QNetworkReply::NetworkError error, QByteArray replyData) {
         CHECK_RESPONSE_NOERROR(partiesFailed, "Requesting parties failed: %d", error);
 
@@ -429,7 +492,7 @@ const RequestInvoker *SRCLinkApiClient::requestPartyEvents()
     CHECK_CLIENT_TOKEN(nullptr);
 
     API_LOG("Requesting party events");
-    auto invoker = new RequestInvoker(sequencer, this);
+    auto invoker = new RequestInvoker(sequencer, RESOURCE_KEY_PARTY_EVENTS, this);
     connect(invoker, &RequestInvoker::finished, [this](QNetworkReply::NetworkError error, QByteArray replyData) {
         CHECK_RESPONSE_NOERROR(partyEventsFailed, "Requesting party events failed: %d", error);
 
@@ -456,7 +519,7 @@ const RequestInvoker *SRCLinkApiClient::requestParticipants()
     CHECK_CLIENT_TOKEN(nullptr);
 
     API_LOG("Requesting participants");
-    auto invoker = new RequestInvoker(sequencer, this);
+    auto invoker = new RequestInvoker(sequencer, RESOURCE_KEY_PARTICIPANTS, this);
     connect(invoker, &RequestInvoker::finished, [this](QNetworkReply::NetworkError error, QByteArray replyData) {
         CHECK_RESPONSE_NOERROR(participantsFailed, "Requesting participants failed: %d", error);
 
@@ -468,10 +531,10 @@ const RequestInvoker *SRCLinkApiClient::requestParticipants()
             return;
         }
 
-        participants = newParticipants;
+        participants.reset(newParticipants);
         API_LOG("Received %d participants", participants.size());
 
-        emit participantsReady(participants);
+        emit participantsReady(participants.toArray());
     });
     invoker->get(QNetworkRequest(QUrl(PARTICIPANTS_URL)));
 
@@ -483,7 +546,7 @@ const RequestInvoker *SRCLinkApiClient::requestStages()
     CHECK_CLIENT_TOKEN(nullptr);
 
     API_LOG("Requesting receivers.");
-    auto invoker = new RequestInvoker(sequencer, this);
+    auto invoker = new RequestInvoker(sequencer, RESOURCE_KEY_STAGES, this);
     connect(invoker, &RequestInvoker::finished, [this](QNetworkReply::NetworkError error, QByteArray replyData) {
         CHECK_RESPONSE_NOERROR(stagesFailed, "Requesting receivers failed: %d", error);
 
@@ -495,10 +558,10 @@ const RequestInvoker *SRCLinkApiClient::requestStages()
             return;
         }
 
-        stages = newStages;
+        stages.reset(newStages);
         API_LOG("Received %d receivers", stages.size());
 
-        emit stagesReady(stages);
+        emit stagesReady(stages.toArray());
     });
     invoker->get(QNetworkRequest(QUrl(STAGES_URL)));
 
@@ -510,7 +573,7 @@ const RequestInvoker *SRCLinkApiClient::requestUplink()
     CHECK_CLIENT_TOKEN(nullptr);
 
     API_LOG("Requesting uplink for %s", qUtf8Printable(uuid));
-    auto invoker = new RequestInvoker(sequencer, this);
+    auto invoker = new RequestInvoker(sequencer, RESOURCE_KEY_UPLINK, this);
     connect(invoker, &RequestInvoker::finished, [this](QNetworkReply::NetworkError error, QByteArray replyData) {
         if (terminating) {
             WARNING_LOG("Ignore the response during terminating");
@@ -545,7 +608,7 @@ const RequestInvoker *SRCLinkApiClient::requestDownlink(const QString &sourceUui
     CHECK_CLIENT_TOKEN(nullptr);
 
     API_LOG("Requesting downlink for %s", qUtf8Printable(sourceUuid));
-    auto invoker = new RequestInvoker(sequencer, this);
+    auto invoker = new RequestInvoker(sequencer, QString(RESOURCE_KEY_DOWNLINK).arg(sourceUuid), this);
     connect(
         invoker, &RequestInvoker::finished,
         [this, sourceUuid](QNetworkReply::NetworkError error, QByteArray replyData) {
@@ -574,6 +637,31 @@ const RequestInvoker *SRCLinkApiClient::requestDownlink(const QString &sourceUui
     return invoker;
 }
 
+// Replace data of the queued PUT request for the same URL instead of queueing new one.
+// Returns nullptr if there is no such request or it has been sent already.
+RequestInvoker *SRCLinkApiClient::supersedePut(const QNetworkRequest &req, const QByteArray &data)
+{
+    auto pending = coalescingPuts.value(req.url().toString());
+    if (pending && pending->supersede(data)) {
+        return pending;
+    }
+    return nullptr;
+}
+
+// Later PUTs to the same URL can supersede the data until the request is sent
+void SRCLinkApiClient::trackCoalescingPut(const QNetworkRequest &req, RequestInvoker *invoker)
+{
+    auto url = req.url().toString();
+    coalescingPuts[url] = invoker;
+
+    connect(invoker, &RequestInvoker::finished, this, [this, url, invoker]() {
+        // Don't erase the entry of the following request
+        if (coalescingPuts.value(url) == invoker) {
+            coalescingPuts.remove(url);
+        }
+    });
+}
+
 const RequestInvoker *SRCLinkApiClient::putDownlink(const QString &sourceUuid, const DownlinkRequestBody &params)
 {
     CHECK_CLIENT_TOKEN(nullptr);
@@ -582,10 +670,19 @@ const RequestInvoker *SRCLinkApiClient::putDownlink(const QString &sourceUuid, c
     req.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
 
     API_LOG("Putting downlink: %s rev.%d", qUtf8Printable(sourceUuid), params.getRevision());
-    auto invoker = new RequestInvoker(sequencer, this);
+    auto data = QJsonDocument(params).toJson(QJsonDocument::Compact);
+    auto pending = supersedePut(req, data);
+    if (pending) {
+        API_LOG("Superseded queued downlink: %s rev.%d", qUtf8Printable(sourceUuid), params.getRevision());
+        return pending;
+    }
+
+    auto invoker = new RequestInvoker(sequencer, QString(RESOURCE_KEY_DOWNLINK).arg(sourceUuid), this);
     connect(
         invoker, &RequestInvoker::finished,
-        [this, sourceUuid, params](QNetworkReply::NetworkError error, QByteArray replyData) {
+        [this, sourceUuid, invoker](QNetworkReply::NetworkError error, QByteArray replyData) {
+            // Later calls may have superseded the params, so refer to the data actually sent
+            DownlinkRequestBody params = QJsonDocument::fromJson(invoker->getRequestData()).object();
             if (error != QNetworkReply::NoError) {
                 ERROR_LOG(
                     "Putting downlink %s rev.%d failed: %d", qUtf8Printable(sourceUuid), params.getRevision(), error
@@ -616,7 +713,8 @@ const RequestInvoker *SRCLinkApiClient::putDownlink(const QString &sourceUuid, c
             emit downlinkReady(downlinks[sourceUuid]);
         }
     );
-    invoker->put(req, QJsonDocument(params).toJson(QJsonDocument::Compact));
+    invoker->put(req, data);
+    trackCoalescingPut(req, invoker);
 
     return invoker;
 }
@@ -629,7 +727,14 @@ const RequestInvoker *SRCLinkApiClient::putDownlinkStatus(const QString &sourceU
     req.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
 
     API_LOG("Putting downlink status: %s", qUtf8Printable(sourceUuid));
-    auto invoker = new RequestInvoker(sequencer, this);
+    auto data = QJsonDocument().toJson(QJsonDocument::Compact);
+    auto pending = supersedePut(req, data);
+    if (pending) {
+        API_LOG("Superseded queued downlink status: %s", qUtf8Printable(sourceUuid));
+        return pending;
+    }
+
+    auto invoker = new RequestInvoker(sequencer, QString(RESOURCE_KEY_DOWNLINK).arg(sourceUuid), this);
     connect(
         invoker, &RequestInvoker::finished,
         [this, sourceUuid](QNetworkReply::NetworkError error, QByteArray replyData) {
@@ -659,7 +764,8 @@ const RequestInvoker *SRCLinkApiClient::putDownlinkStatus(const QString &sourceU
             emit downlinkReady(downlinks[sourceUuid]);
         }
     );
-    invoker->put(req, QJsonDocument().toJson(QJsonDocument::Compact));
+    invoker->put(req, data);
+    trackCoalescingPut(req, invoker);
 
     return invoker;
 }
@@ -671,7 +777,8 @@ const RequestInvoker *SRCLinkApiClient::deleteDownlink(const QString &sourceUuid
     auto req = QNetworkRequest(QUrl(QString(DOWNLINK_URL).arg(sourceUuid)));
 
     API_LOG("Deleting downlink of %s", qUtf8Printable(sourceUuid));
-    auto invoker = !parallel ? new RequestInvoker(sequencer, this) : new RequestInvoker(networkManager, client, this);
+    auto invoker = !parallel ? new RequestInvoker(sequencer, QString(RESOURCE_KEY_DOWNLINK).arg(sourceUuid), this)
+                             : new RequestInvoker(networkManager, client, this);
     connect(invoker, &RequestInvoker::finished, [this, sourceUuid](QNetworkReply::NetworkError error, QByteArray) {
         if (error != QNetworkReply::NoError) {
             ERROR_LOG("Deleting downlink of %s failed: %d", qUtf8Printable(sourceUuid), error);
@@ -711,7 +818,7 @@ const RequestInvoker *SRCLinkApiClient::putUplink()
         "Putting uplink of %s (participant=%s, force=%s)", qUtf8Printable(uuid),
         qUtf8Printable(body["participant_id"].toString()), qUtf8Printable(body["force"].toString())
     );
-    auto invoker = new RequestInvoker(sequencer, this);
+    auto invoker = new RequestInvoker(sequencer, RESOURCE_KEY_UPLINK, this);
     connect(invoker, &RequestInvoker::finished, [this](QNetworkReply::NetworkError error, QByteArray replyData) {
         if (terminating) {
             WARNING_LOG("Ignore the response during terminating");
@@ -761,7 +868,14 @@ const RequestInvoker *SRCLinkApiClient::putUplinkStatus()
     body["uplink_status"] = uplinkStatus;
 
     API_LOG("Putting uplink status of %s", qUtf8Printable(uuid));
-    auto invoker = new RequestInvoker(sequencer, this);
+    auto data = QJsonDocument(body).toJson(QJsonDocument::Compact);
+    auto pending = supersedePut(req, data);
+    if (pending) {
+        API_LOG("Superseded queued uplink status of %s", qUtf8Printable(uuid));
+        return pending;
+    }
+
+    auto invoker = new RequestInvoker(sequencer, RESOURCE_KEY_UPLINK, this);
     connect(invoker, &RequestInvoker::finished, [this](QNetworkReply::NetworkError error, QByteArray replyData) {
         if (terminating) {
             WARNING_LOG("Ignore the response during terminating");
@@ -789,7 +903,8 @@ const RequestInvoker *SRCLinkApiClient::putUplinkStatus()
         emit putUplinkStatusSucceeded(uplink);
         emit uplinkReady(uplink);
     });
-    invoker->put(req, QJsonDocument(body).toJson(QJsonDocument::Compact));
+    invoker->put(req, data);
+    trackCoalescingPut(req, invoker);
 
     return invoker;
 }
@@ -801,7 +916,8 @@ const RequestInvoker *SRCLinkApiClient::deleteUplink(const bool parallel)
     auto req = QNetworkRequest(QUrl(QString(UPLINK_URL).arg(uuid)));
 
     API_LOG("Deleting uplink of %s", qUtf8Printable(uuid));
-    auto invoker = !parallel ? new RequestInvoker(sequencer, this) : new RequestInvoker(networkManager, client, this);
+    auto invoker = !parallel ? new RequestInvoker(sequencer, RESOURCE_KEY_UPLINK, this)
+                             : new RequestInvoker(networkManager, client, this);
     connect(invoker, &RequestInvoker::finished, [this](QNetworkReply::NetworkError error, QByteArray) {
         if (error != QNetworkReply::NoError) {
             ERROR_LOG("Deleting uplink of %s failed: %d", qUtf8Printable(uuid), error);
@@ -832,7 +948,7 @@ const RequestInvoker *SRCLinkApiClient::redeemInviteCode(const QString &inviteCo
     body["invite_code"] = inviteCode;
 
     API_LOG("Activating member for %s", qUtf8Printable(inviteCode));
-    auto invoker = new RequestInvoker(sequencer, this);
+    auto invoker = new RequestInvoker(sequencer, RESOURCE_KEY_PARTICIPANTS, this);
     connect(
         invoker, &RequestInvoker::finished,
         [this, inviteCode](QNetworkReply::NetworkError error, QByteArray replyData) {
@@ -847,14 +963,7 @@ const RequestInvoker *SRCLinkApiClient::redeemInviteCode(const QString &inviteCo
 
             // Marge participants
             for (const auto &participant : result.getParticipants().values()) {
-                auto index = participants.findIndex([participant](const PartyEventParticipant &p) {
-                    return p.getId() == participant.getId();
-                });
-                if (index >= 0) {
-                    participants.replace(index, participant);
-                } else {
-                    participants.append(participant);
-                }
+                participants.upsert(participant);
             }
 
             if (result.getParticipants().size() > 0) {
@@ -865,7 +974,7 @@ const RequestInvoker *SRCLinkApiClient::redeemInviteCode(const QString &inviteCo
             }
 
             emit redeemInviteCodeSucceeded(result);
-            emit participantsReady(participants);
+            emit participantsReady(participants.toArray());
         }
     );
     invoker->post(req, QJsonDocument(body).toJson(QJsonDocument::Compact));
@@ -873,49 +982,131 @@ const RequestInvoker *SRCLinkApiClient::redeemInviteCode(const QString &inviteCo
     return invoker;
 }
 
-// Upload statistics via wewbsocket
+// Queue statistics, they are uploaded in batch every STATISTICS_FLUSH_INTERVAL_MSECS
+// Flush immediately if the state is changed
 void SRCLinkApiClient::putStatistics(
-    const QString &sourceName, const QString &status, bool recording, const OutputMetric &metric
+    const QString &sourceName, const QString &status, bool recording, const OutputMetric &metric, bool immediate
 )
 {
-    CHECK_CLIENT_TOKEN();
-
-    json payload;
-
-    payload["uuid"] = qUtf8Printable(uuid);
-    payload["source_name"] = qUtf8Printable(sourceName);
-    payload["status"] = qUtf8Printable(status);
-    payload["recording"] = recording;
-    payload["metric"] = {
-        {"bitrate", metric.getBitrate()},
-        {"total_frames", metric.getTotalFrames()},
-        {"dropped_frames", metric.getDroppedFrames()},
-        {"total_size", metric.getTotalSize()}
-    };
-
-    websocket->invokeBin("statistics.put", payload);
+    // Overwrite older one
+    auto &entry = pendingStatistics[sourceName];
+    entry.status = status;
+    entry.recording = recording;
+    entry.metric = metric;
+
+    if (immediate) {
+        flushStatistics();
+    }
 }
 
-// Upload screenshot via websocket
-void SRCLinkApiClient::putScreenshot(const QString &sourceName, const QImage &image)
+// Upload queued statistics via wewbsocket
+void SRCLinkApiClient::flushStatistics()
 {
+    if (pendingStatistics.isEmpty()) {
+        return;
+    }
+
+    if (!websocket->isServerReady()) {
+        // Keep the latest statistics of each output until the server gets ready
+        return;
+    }
+
     CHECK_CLIENT_TOKEN();
 
-    QByteArray imageBytes;
-    QBuffer imageBuffer(&imageBytes);
-    imageBuffer.open(QIODevice::WriteOnly);
-    image.save(&imageBuffer, "JPG", SCREENSHOT_QUALITY);
+    if (!websocket->hasServerCapability(WEBSOCKET_CAPABILITY_STATISTICS_BATCH)) {
+        // Fallback for servers which don't know the batch, put each output in the legacy format
+        for (auto it = pendingStatistics.constBegin(); it != pendingStatistics.constEnd(); it++) {
+            const auto &metric = it->metric;
+            json payload;
+            payload["uuid"] = qUtf8Printable(uuid);
+            payload["source_name"] = qUtf8Printable(it.key());
+            payload["status"] = qUtf8Printable(it->status);
+            payload["recording"] = it->recording;
+            payload["metric"] = {
+                {"bitrate", metric.getBitrate()},
+                {"total_frames", metric.getTotalFrames()},
+                {"dropped_frames", metric.getDroppedFrames()},
+                {"total_size", metric.getTotalSize()},
+                {"congestion", metric.getCongestion()},
+                {"connect_time", metric.getConnectTime()},
+                {"activation_latency", metric.getActivationLatency()},
+                {"skipped_frames", metric.getSkippedFrames()},
+                {"configured_keyframe_interval", metric.getConfiguredKeyframeInterval()}
+            };
+            websocket->invokeBin("statistics.put", std::move(payload), OUTBOUND_PRIORITY_LOW);
+        }
+        pendingStatistics.clear();
+        return;
+    }
 
     json payload;
-
     payload["uuid"] = qUtf8Printable(uuid);
-    payload["source_name"] = qUtf8Printable(sourceName);
-    payload["mime_type"] = "image/jpeg";
 
-    auto bufferPtr = imageBuffer.data().constData();
-    payload["body"] = json::binary_t(std::vector<uint8_t>(bufferPtr, bufferPtr + imageBuffer.data().size()));
+    auto &items = payload["statistics"] = json::array();
+    for (auto it = pendingStatistics.constBegin(); it != pendingStatistics.constEnd(); it++) {
+        const auto &metric = it->metric;
+        items.push_back(
+            {{"source_name", qUtf8Printable(it.key())},
+             {"status", qUtf8Printable(it->status)},
+             {"recording", it->recording},
+             {"metric",
+              {{"bitrate", metric.getBitrate()},
+               {"total_frames", metric.getTotalFrames()},
+               {"dropped_frames", metric.getDroppedFrames()},
+               {"total_size", metric.getTotalSize()},
+               {"congestion", metric.getCongestion()},
+               {"connect_time", metric.getConnectTime()},
+               {"activation_latency", metric.getActivationLatency()},
+               {"skipped_frames", metric.getSkippedFrames()},
+               {"configured_keyframe_interval", metric.getConfiguredKeyframeInterval()}}}}
+        );
+    }
+    pendingStatistics.clear();
+
+    websocket->invokeBin(WEBSOCKET_CAPABILITY_STATISTICS_BATCH, std::move(payload), OUTBOUND_PRIORITY_LOW);
+}
+
+// Upload screenshot via websocket
+bool SRCLinkApiClient::putScreenshot(const QString &sourceName, const QImage &image)
+{
+    CHECK_CLIENT_TOKEN(false);
+
+    if (pendingScreenshots.contains(sourceName)) {
+        // The previous one is still being encoded -> Drop this
+        return false;
+    }
+    pendingScreenshots.insert(sourceName);
+
+    // Encode JPEG and BSON on the worker, the main thread only sends the message
+    auto clientUuid = uuid;
+    screenshotPool->start([this, clientUuid, sourceName, image]() {
+        std::vector<uint8_t> imageBytes;
+        VectorWriteDevice imageDevice(imageBytes);
+        image.save(&imageDevice, "JPG", SCREENSHOT_QUALITY);
+
+        json payload;
+
+        payload["uuid"] = qUtf8Printable(clientUuid);
+        payload["source_name"] = qUtf8Printable(sourceName);
+        payload["mime_type"] = "image/jpeg";
+        payload["body"] = json::binary_t(std::move(imageBytes));
+
+        auto message = SRCLinkWebSocketClient::encodeInvokeBin("screenshots.put", std::move(payload));
+
+        QMetaObject::invokeMethod(
+            this,
+            [this, sourceName, message]() {
+                pendingScreenshots.remove(sourceName);
+                // Only the latest screenshot of each source is worth sending after reconnection
+                websocket->sendBin(
+                    "screenshots.put", message, OUTBOUND_PRIORITY_LOW, QString("screenshots.put:%1").arg(sourceName)
+                );
+            },
+            Qt::QueuedConnection
+        );
+    });
 
-    websocket->invokeBin("screenshots.put", payload);
+    return true;
 }
 
 void SRCLinkApiClient::getPicture(const QString &pictureId)
@@ -987,6 +1178,7 @@ void SRCLinkApiClient::onO2LinkingSucceeded()
 
         if (accountInfo.isEmpty()) {
             // Called only the first time after logging in
+            readyStartedAt = QDateTime::currentMSecsSinceEpoch();
             connect(requestAccountInfo(), &RequestInvoker::finished, this, [this](QNetworkReply::NetworkError error) {
                 if (error != QNetworkReply::NoError) {
                     return;
@@ -1036,6 +1228,11 @@ void SRCLinkApiClient::onO2RefreshFinished(QNetworkReply::NetworkError error)
 void SRCLinkApiClient::onWebSocketReady(bool reconnect)
 {
     API_LOG("WebSocket is ready.");
+    if (!reconnect && readyStartedAt) {
+        // From startup or login, includes token refresh, account info, uplink and WebSocket handshake
+        INFO_LOG("Time to ready: %lld ms", QDateTime::currentMSecsSinceEpoch() - readyStartedAt);
+        readyStartedAt = 0;
+    }
     // The account info will be received by requestAccountInfo() except on reconnecting
     websocket->subscribe("accounts", {{"initial_data", reconnect}});
     // The uplink will be received by WebSocket except on reconnecting
@@ -1060,6 +1257,9 @@ void SRCLinkApiClient::onWebSocketReady(bool reconnect)
         syncUplinkStatus(true);
     }
 
+    // Send statistics held while offline
+    flushStatistics();
+
     emit ready(reconnect);
 }
 
@@ -1084,7 +1284,6 @@ void SRCLinkApiClient::onWebSocketDataChanged(const WebSocketMessage &message)
     auto payload = message.getPayload();
     API_LOG("WebSocket data changed: %s,%s,%d", qUtf8Printable(name), qUtf8Printable(id), message.getContinuous());
 
-    blockSignals(message.getContinuous());
     [&]() {
         if (name == "uplink.allocations") {
             StageSeatAllocation newAllocation = payload;
@@ -1095,7 +1294,7 @@ void SRCLinkApiClient::onWebSocketDataChanged(const WebSocketMessage &message)
             }
 
             uplink.setAllocation(newAllocation);
-            emit uplinkReady(uplink);
+            uplinkChanged = true;
 
         } else if (name == "uplink.stages") {
             Stage newStage = payload;
@@ -1106,7 +1305,7 @@ void SRCLinkApiClient::onWebSocketDataChanged(const WebSocketMessage &message)
             }
 
             uplink.setStage(newStage);
-            emit uplinkReady(uplink);
+            uplinkChanged = true;
 
         } else if (name == "uplink.connections") {
             StageConnection newConnection = payload;
@@ -1125,7 +1324,7 @@ void SRCLinkApiClient::onWebSocketDataChanged(const WebSocketMessage &message)
                 connections.append(newConnection);
             }
             uplink["connections"] = connections;
-            emit uplinkReady(uplink);
+            uplinkChanged = true;
 
         } else if (name == "downlink.connections") {
             StageConnection newConnection = payload;
@@ -1135,8 +1334,9 @@ void SRCLinkApiClient::onWebSocketDataChanged(const WebSocketMessage &message)
                 return;
             }
 
+            auto inserted = !downlinks.contains(id);
             downlinks[id]["connection"] = newConnection;
-            emit downlinkReady(downlinks[id]);
+            downlinkChanges.markUpserted(id, inserted);
 
         } else if (name == "stages") {
             Stage newStage = payload;
@@ -1146,13 +1346,7 @@ void SRCLinkApiClient::onWebSocketDataChanged(const WebSocketMessage &message)
                 return;
             }
 
-            auto index = stages.findIndex([id](const Stage &stage) { return stage.getId() == id; });
-            if (index >= 0) {
-                stages.replace(index, newStage);
-            } else {
-                stages.append(newStage);
-            }
-            emit stagesReady(stages);
+            stageChanges.markUpserted(id, stages.upsert(newStage));
 
         } else if (name == "participants") {
             PartyEventParticipant newParticipant = payload;
@@ -1162,13 +1356,7 @@ void SRCLinkApiClient::onWebSocketDataChanged(const WebSocketMessage &message)
                 return;
             }
 
-            auto index = participants.findIndex([id](const PartyEventParticipant &p) { return p.getId() == id; });
-            if (index >= 0) {
-                participants.replace(index, newParticipant);
-            } else {
-                participants.append(newParticipant);
-            }
-            emit participantsReady(participants);
+            participantChanges.markUpserted(id, participants.upsert(newParticipant));
 
         } else if (name == "accounts") {
             Account newAccount = payload;
@@ -1179,7 +1367,7 @@ void SRCLinkApiClient::onWebSocketDataChanged(const WebSocketMessage &message)
             }
 
             accountInfo.setAccount(newAccount);
-            emit accountInfoReady(accountInfo);
+            accountInfoChanged = true;
 
         } else if (name == "accounts.licenses") {
             SubscriptionLicense newLicense = payload;
@@ -1189,15 +1377,14 @@ void SRCLinkApiClient::onWebSocketDataChanged(const WebSocketMessage &message)
                 return;
             }
 
-            auto emitLicenseChanged = !accountInfo.isEmpty() && accountInfo.getSubscriptionLicense().getLicenseValid(
-                                                                ) != newLicense.getLicenseValid();
+            if (!accountInfo.isEmpty() &&
+                accountInfo.getSubscriptionLicense().getLicenseValid() != newLicense.getLicenseValid()) {
+                // Flipping twice within a tick results in no change
+                licenseValidityChanged = !licenseValidityChanged;
+            }
 
             accountInfo.setSubscriptionLicense(newLicense);
-            emit accountInfoReady(accountInfo);
-
-            if (emitLicenseChanged) {
-                emit licenseChanged(newLicense);
-            }
+            accountInfoChanged = true;
 
         } else if (name == "accounts.resourceUsage") {
             AccountResourceUsage newResourceUsage = payload;
@@ -1208,7 +1395,7 @@ void SRCLinkApiClient::onWebSocketDataChanged(const WebSocketMessage &message)
             }
 
             accountInfo.setResourceUsage(newResourceUsage);
-            emit accountInfoReady(accountInfo);
+            accountInfoChanged = true;
 
         } else if (name == "ws-portals") {
             WsPortal newPortal = payload;
@@ -1218,16 +1405,11 @@ void SRCLinkApiClient::onWebSocketDataChanged(const WebSocketMessage &message)
                 return;
             }
 
-            auto index = wsPortals.findIndex([id](const WsPortal &portal) { return portal.getId() == id; });
-            if (index >= 0) {
-                wsPortals.replace(index, newPortal);
-            } else {
-                wsPortals.append(newPortal);
-            }
-            emit wsPortalsReady(wsPortals);
+            wsPortalChanges.markUpserted(id, wsPortals.upsert(newPortal));
         }
     }();
-    blockSignals(false);
+
+    scheduleWebSocketChanges(message.getContinuous());
 }
 
 void SRCLinkApiClient::onWebSocketDataRemoved(const WebSocketMessage &message)
@@ -1236,18 +1418,17 @@ void SRCLinkApiClient::onWebSocketDataRemoved(const WebSocketMessage &message)
     auto id = message.getId();
     API_LOG("WebSocket data removed: %s,%s,%d", qUtf8Printable(name), qUtf8Printable(id), message.getContinuous());
 
-    blockSignals(message.getContinuous());
     [&]() {
         if (name == "uplink.allocations") {
             if (uplink.getAllocation().getId() == id) {
                 uplink.remove("allocation");
-                emit uplinkReady(uplink);
+                uplinkChanged = true;
             }
 
         } else if (name == "uplink.stages") {
             if (uplink.getStage().getId() == id) {
                 uplink.remove("stage");
-                emit uplinkReady(uplink);
+                uplinkChanged = true;
             }
 
         } else if (name == "uplink.connections") {
@@ -1257,29 +1438,23 @@ void SRCLinkApiClient::onWebSocketDataRemoved(const WebSocketMessage &message)
             if (index >= 0) {
                 connections.removeAt(index);
                 uplink["connections"] = connections;
-                emit uplinkReady(uplink);
+                uplinkChanged = true;
             }
 
         } else if (name == "downlink.connections") {
             if (downlinks.contains(id)) {
                 downlinks.remove(id);
-                emit downlinkRemoved(id);
+                downlinkChanges.markRemoved(id);
             }
 
         } else if (name == "stages") {
-            auto index = stages.findIndex([id](const Stage &stage) { return stage.getId() == id; });
-            if (index >= 0) {
-                stages.removeAt(index);
-                emit stagesReady(stages);
+            if (stages.remove(id)) {
+                stageChanges.markRemoved(id);
             }
 
         } else if (name == "participants") {
-            auto index = participants.findIndex([id](const PartyEventParticipant &participant) {
-                return participant.getId() == id;
-            });
-            if (index >= 0) {
-                participants.removeAt(index);
-                emit participantsReady(participants);
+            if (participants.remove(id)) {
+                participantChanges.markRemoved(id);
             }
 
         } else if (name == "accounts.licenses" || name == "accounts.resourceUsage") {
@@ -1290,12 +1465,97 @@ void SRCLinkApiClient::onWebSocketDataRemoved(const WebSocketMessage &message)
             logout();
 
         } else if (name == "ws-portals") {
-            auto index = wsPortals.findIndex([id](const WsPortal &portal) { return portal.getId() == id; });
-            if (index >= 0) {
-                wsPortals.removeAt(index);
-                emit wsPortalsReady(wsPortals);
+            if (wsPortals.remove(id)) {
+                wsPortalChanges.markRemoved(id);
             }
         }
     }();
-    blockSignals(false);
+
+    scheduleWebSocketChanges(message.getContinuous());
+}
+
+// Changes are emitted once per tick. During continuous data (e.g. initial sync),
+// they are held until the burst ends or WEBSOCKET_CHANGES_MAX_DELAY_MSECS elapsed.
+void SRCLinkApiClient::scheduleWebSocketChanges(bool continuous)
+{
+    if (!continuous) {
+        webSocketChangesTimer->start(0);
+    } else if (!webSocketChangesTimer->isActive()) {
+        webSocketChangesTimer->start(WEBSOCKET_CHANGES_MAX_DELAY_MSECS);
+    }
+}
+
+// A few changes are emitted as per-item signals, otherwise the full collection is emitted once
+template<typename T, typename ReadySignal, typename ItemSignal, typename RemovedSignal>
+static void emitCollectionChanges(
+    SRCLinkApiClient *sender, CollectionChanges &changes, const TypedJsonStore<T> &store, ReadySignal ready,
+    ItemSignal added, ItemSignal changed, RemovedSignal removed
+)
+{
+    if (changes.isEmpty()) {
+        return;
+    }
+
+    if (changes.size() > WEBSOCKET_MAX_ITEM_SIGNALS) {
+        changes.clear();
+        emit(sender->*ready)(store.toArray());
+        return;
+    }
+
+    // Signals may cause further changes, so take them first
+    auto current = changes;
+    changes.clear();
+
+    for (const auto &id : current.added) {
+        emit(sender->*added)(id, store.value(id));
+    }
+    for (const auto &id : current.changed) {
+        emit(sender->*changed)(id, store.value(id));
+    }
+    for (const auto &id : current.removed) {
+        emit(sender->*removed)(id);
+    }
+}
+
+void SRCLinkApiClient::emitWebSocketChanges()
+{
+    if (uplinkChanged) {
+        uplinkChanged = false;
+        emit uplinkReady(uplink);
+    }
+
+    if (!downlinkChanges.isEmpty()) {
+        auto current = downlinkChanges;
+        downlinkChanges.clear();
+        for (const auto &id : current.added + current.changed) {
+            emit downlinkReady(downlinks.value(id));
+        }
+        for (const auto &id : current.removed) {
+            emit downlinkRemoved(id);
+        }
+    }
+
+    emitCollectionChanges(
+        this, stageChanges, stages, &SRCLinkApiClient::stagesReady, &SRCLinkApiClient::stageAdded,
+        &SRCLinkApiClient::stageChanged, &SRCLinkApiClient::stageRemoved
+    );
+    emitCollectionChanges(
+        this, participantChanges, participants, &SRCLinkApiClient::participantsReady,
+        &SRCLinkApiClient::participantAdded, &SRCLinkApiClient::participantChanged,
+        &SRCLinkApiClient::participantRemoved
+    );
+    emitCollectionChanges(
+        this, wsPortalChanges, wsPortals, &SRCLinkApiClient::wsPortalsReady, &SRCLinkApiClient::wsPortalAdded,
+        &SRCLinkApiClient::wsPortalChanged, &SRCLinkApiClient::wsPortalRemoved
+    );
+
+    if (accountInfoChanged) {
+        accountInfoChanged = false;
+        emit accountInfoReady(accountInfo);
+    }
+
+    if (licenseValidityChanged) {
+        licenseValidityChanged = false;
+        emit licenseChanged(accountInfo.getSubscriptionLicense());
+    }
 }
@@ -22,6 +22,10 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #include <QByteArray>
 #include <QException>
 #include <QTimer>
+#include <QThreadPool>
+#include <QSet>
+#include <QMap>
+#include <QPointer>
 
 #include <o2.h>
 
@@ -43,6 +47,50 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #define OUTPUT_STATUS_RECONNECTING "reconnecting"
 #define OUTPUT_STATUS_STAND_BY "standby"
 
+struct PendingStatistics {
+    QString status;
+    bool recording;
+    OutputMetric metric;
+};
+
+// IDs of changed items in a collection, merged within a tick
+struct CollectionChanges {
+    QSet<QString> added;
+    QSet<QString> changed;
+    QSet<QString> removed;
+
+    void markUpserted(const QString &id, bool inserted)
+    {
+        if (!inserted) {
+            if (!added.contains(id)) {
+                changed.insert(id);
+            }
+        } else if (removed.remove(id)) {
+            // Removed and added again
+            changed.insert(id);
+        } else {
+            added.insert(id);
+        }
+    }
+
+    void markRemoved(const QString &id)
+    {
+        changed.remove(id);
+        if (!added.remove(id)) {
+            removed.insert(id);
+        }
+    }
+
+    inline bool isEmpty() const { return added.isEmpty() && changed.isEmpty() && removed.isEmpty(); }
+    inline qsizetype size() const { return added.size() + changed.size() + removed.size(); }
+    inline void clear()
+    {
+        added.clear();
+        changed.clear();
+        removed.clear();
+    }
+};
+
 class SRCLinkApiClient : public QObject {
     Q_OBJECT
 
@@ -61,18 +109,36 @@ class SRCLinkApiClient : public QObject {
     QString uplinkStatus;
     bool terminating;
     QTimer *tokenRefreshTimer;
+    qint64 readyStartedAt; // For time-to-ready, 0 means measured
+    QThreadPool *screenshotPool;
+    QSet<QString> pendingScreenshots; // Source names of which screenshot is being encoded
+    QTimer *statisticsFlushTimer;
+    QMap<QString, PendingStatistics> pendingStatistics; // Latest statistics of each source name
+    QMap<QString, QPointer<RequestInvoker>> coalescingPuts; // Last PUT request for each URL
+    // WebSocket changes to be emitted in the next tick
+    QTimer *webSocketChangesTimer;
+    bool uplinkChanged;
+    bool accountInfoChanged;
+    bool licenseValidityChanged;
+    CollectionChanges downlinkChanges;
+    CollectionChanges stageChanges;
+    CollectionChanges participantChanges;
+    CollectionChanges wsPortalChanges;
 
     // Online rsources
     AccountInfo accountInfo;
     PartyArray parties;
     PartyEventArray partyEvents;             // Contains all events of all parties
-    PartyEventParticipantArray participants; // Contains all participants of all events
-    StageArray stages;
+    TypedJsonStore<PartyEventParticipant> participants; // Contains all participants of all events
+    TypedJsonStore<Stage> stages;
     UplinkInfo uplink;
     QMap<QString, DownlinkInfo> downlinks;
-    WsPortalArray wsPortals;
+    TypedJsonStore<WsPortal> wsPortals;
 
     inline QString getAccessToken() { return client->token(); }
+    RequestInvoker *supersedePut(const QNetworkRequest &req, const QByteArray &data);
+    void trackCoalescingPut(const QNetworkRequest &req, RequestInvoker *invoker);
+    void scheduleWebSocketChanges(bool continuous);
 
 signals:
     void loginSucceeded();
@@ -86,9 +152,17 @@ signals:
     void partiesFailed();
     void partyEventsReady(const PartyEventArray &partyEvents);
     void partyEventsFailed();
+    // Full collection signals are emitted on bulk updates,
+    // WebSocket changes emit per-item signals unless many items changed within a tick
     void stagesReady(const StageArray &stages);
+    void stageAdded(const QString &id, const Stage &stage);
+    void stageChanged(const QString &id, const Stage &stage);
+    void stageRemoved(const QString &id);
     void stagesFailed();
     void participantsReady(const PartyEventParticipantArray &participants);
+    void participantAdded(const QString &id, const PartyEventParticipant &participant);
+    void participantChanged(const QString &id, const PartyEventParticipant &participant);
+    void participantRemoved(const QString &id);
     void participantsFailed();
     void uplinkReady(const UplinkInfo &uplink);
     void uplinkFailed(const QString &uuid);
@@ -117,6 +191,9 @@ signals:
     void egressRefreshNeeded();
     void licenseChanged(const SubscriptionLicense &license);
     void wsPortalsReady(const WsPortalArray &wsPortals);
+    void wsPortalAdded(const QString &id, const WsPortal &wsPortal);
+    void wsPortalChanged(const QString &id, const WsPortal &wsPortal);
+    void wsPortalRemoved(const QString &id);
     void wsPortalsFailed();
     void webSocketSubscribeSucceeded(const QString &name, const QJsonObject &payload);
     void webSocketSubscribeFailed(const QString &name, const QJsonObject &payload);
@@ -124,6 +201,7 @@ signals:
     void webSocketUnsubscribeFailed(const QString &name, const QJsonObject &payload);
     void webSocketInvokeSucceeded(const QString &name, const QJsonObject &payload);
     void webSocketInvokeFailed(const QString &name, const QJsonObject &payload);
+    void linkHealthUpdated(const LinkHealth &health);
 
 private slots:
     void onO2LinkedChanged();
@@ -136,6 +214,7 @@ private slots:
     void onWebSocketDisconnected();
     void onWebSocketDataChanged(const WebSocketMessage &message);
     void onWebSocketDataRemoved(const WebSocketMessage &message);
+    void emitWebSocketChanges();
 
 public:
     explicit SRCLinkApiClient(QObject *parent = nullptr);
@@ -145,11 +224,14 @@ public:
     inline const AccountInfo getAccountInfo() const { return accountInfo; }
     inline const PartyArray &getParties() const { return parties; }
     inline const PartyEventArray &getPartyEvents() const { return partyEvents; }
-    inline const PartyEventParticipantArray &getParticipants() const { return participants; }
-    inline const StageArray &getStages() const { return stages; }
+    inline const PartyEventParticipantArray &getParticipants() const { return participants.toArray(); }
+    inline const PartyEventParticipant getParticipant(const QString &id) const { return participants.value(id); }
+    inline const StageArray &getStages() const { return stages.toArray(); }
     inline const UplinkInfo getUplink() const { return uplink; }
     inline SRCLinkSettingsStore *getSettings() const { return settings; }
-    inline const WsPortalArray &getWsPortals() const { return wsPortals; }
+    inline const LinkHealth getLinkHealth() const { return websocket->getHealthMonitor()->getHealth(); }
+    inline const WsPortalArray &getWsPortals() const { return wsPortals.toArray(); }
+    inline const WsPortal getWsPortal(const QString &id) const { return wsPortals.value(id); }
 
 public slots:
     void login();
@@ -172,8 +254,13 @@ public slots:
     const RequestInvoker *putUplinkStatus();
     const RequestInvoker *deleteUplink(const bool parallel = false);
     const RequestInvoker *redeemInviteCode(const QString &inviteCode);
-    void putStatistics(const QString &sourceName, const QString &status, bool recording, const OutputMetric &metric);
-    void putScreenshot(const QString &sourceName, const QImage &image);
+    void putStatistics(
+        const QString &sourceName, const QString &status, bool recording, const OutputMetric &metric,
+        bool immediate = false
+    );
+    void flushStatistics();
+    // Returns false if the image was dropped
+    bool putScreenshot(const QString &sourceName, const QImage &image);
     void getPicture(const QString &pitureId);
     void refreshIngress() { emit ingressRefreshNeeded(); }
     void refreshEgress() { emit egressRefreshNeeded(); }
@@ -17,12 +17,35 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 */
 
 #include <QJsonDocument>
+#include <QJsonArray>
+#include <QUrlQuery>
+#include <QHash>
+#include <QDateTime>
+#include <QTimeZone>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+#include <util/platform.h>
 
 #include "plugin-support.h"
 #include "api-websocket.hpp"
 #include "api-client.hpp"
 
 #define INTERVAL_INTERVAL_MSECS 30000
+// Server sends binary frames when requested, text frames are still accepted
+#define INBOUND_ENCODING "bson"
+// QtWebSockets doesn't support permessage-deflate, so the server wraps binary frames with the envelope:
+// [00 00 00 00 (never appears at the head of BSON)] [method 'D'] [qCompress() output]
+// The server confirms by the capability in "ready" (sent uncompressed) and compresses only after that.
+// Text frames are never compressed, they are sent only when the server ignores INBOUND_ENCODING.
+#define INBOUND_COMPRESSION "deflate"
+#define WEBSOCKET_CAPABILITY_COMPRESSION "compression.deflate"
+#define ENVELOPE_MAGIC_SIZE 4
+#define ENVELOPE_HEADER_SIZE 5
+#define ENVELOPE_METHOD_DEFLATE 'D'
+#define OUTBOUND_QUEUE_MAX_SIZE 64
 
 //#define API_DEBUG
 
@@ -42,15 +65,30 @@ SRCLinkWebSocketClient::SRCLinkWebSocketClient(QUrl _url, SRCLinkApiClient *_api
       apiClient(_apiClient),
       url(_url),
       started(false),
-      reconnectCount(0)
+      serverReady(false),
+      reconnectCount(0),
+      compressedBytes(0),
+      decompressedBytes(0),
+      decompressionNsecs(0),
+      reportedCompressedBytes(0)
 {
     intervalTimer = new QTimer(this);
+    reconnectTimer = new QTimer(this);
+    reconnectTimer->setSingleShot(true);
+    connect(reconnectTimer, &QTimer::timeout, this, [this]() {
+        if (started) {
+            open();
+        }
+    });
     client = new QWebSocket("https://" + url.host(), QWebSocketProtocol::Version13, this);
 
     connect(client, SIGNAL(connected()), this, SLOT(onConnected()));
     connect(client, SIGNAL(disconnected()), this, SLOT(onDisconnected()));
-    connect(client, SIGNAL(pong(quint64, const QByteArray &)), this, SLOT(onPong(quint64, const QByteArray &)));
     connect(client, SIGNAL(textMessageReceived(QString)), this, SLOT(onTextMessageReceived(QString)));
+    connect(
+        client, SIGNAL(binaryMessageReceived(const QByteArray &)), this,
+        SLOT(onBinaryMessageReceived(const QByteArray &))
+    );
 
     /* Required Qt 6.5 (Error on Ubuntu 22.04)
     connect(client, &QWebSocket::errorOccurred, [this](QAbstractSocket::SocketError error) {
@@ -58,12 +96,15 @@ SRCLinkWebSocketClient::SRCLinkWebSocketClient(QUrl _url, SRCLinkApiClient *_api
     });
     */
 
-    // Setup interval timer for pinging
-    connect(intervalTimer, &QTimer::timeout, [this]() {
-        if (started && client->isValid()) {
-            client->ping();
-        }
+    // Pings are sent by the health monitor
+    healthMonitor = new LinkHealthMonitor("api", apiClient->getSettings()->getNetworkPingInterval() * 1000, this);
+    healthMonitor->attach(client);
+    connect(healthMonitor, &LinkHealthMonitor::unresponsive, this, [this]() {
+        // Half-open connection, disconnected() triggers reconnection
+        client->abort();
     });
+
+    connect(intervalTimer, &QTimer::timeout, [this]() { reportCompression(); });
     intervalTimer->setInterval(INTERVAL_INTERVAL_MSECS);
     intervalTimer->start();
 
@@ -84,10 +125,16 @@ void SRCLinkWebSocketClient::onConnected()
 
 void SRCLinkWebSocketClient::onDisconnected()
 {
+    serverReady = false;
+    // Announced again in "ready" of the next connection
+    serverCapabilities.clear();
+
     if (started) {
-        API_LOG("Reconnecting");
+        // Avoid tight reconnect loop during server outage
+        auto delay = reconnectBackoff.next();
+        API_LOG("Reconnecting in %d ms", delay);
         reconnectCount++;
-        open();
+        reconnectTimer->start(delay);
         emit reconnecting();
     } else {
         API_LOG("Disconnected");
@@ -95,41 +142,319 @@ void SRCLinkWebSocketClient::onDisconnected()
     }
 }
 
-void SRCLinkWebSocketClient::onPong(quint64 elapsedTime, const QByteArray &)
+//--- BsonReader class ---//
+
+// Decodes BSON into Qt's JSON representation in one pass, without intermediate DOM.
+// Datetime becomes an ISO-8601 string (UTC) and binary becomes a base64 string.
+class BsonReader {
+    const char *cur;
+    const char *end;
+
+    template<typename T> bool readNumber(T *value)
+    {
+        if (end - cur < (ptrdiff_t)sizeof(T)) {
+            return false;
+        }
+        *value = qFromLittleEndian<T>(cur);
+        cur += sizeof(T);
+        return true;
+    }
+
+    bool readKey(QString *key)
+    {
+        auto terminator = static_cast<const char *>(memchr(cur, '\0', end - cur));
+        if (!terminator) {
+            return false;
+        }
+        *key = QString::fromUtf8(cur, terminator - cur);
+        cur = terminator + 1;
+        return true;
+    }
+
+    bool readString(QJsonValue *value)
+    {
+        qint32 length;
+        if (!readNumber(&length) || length < 1 || end - cur < length || cur[length - 1] != '\0') {
+            return false;
+        }
+        *value = QString::fromUtf8(cur, length - 1);
+        cur += length;
+        return true;
+    }
+
+    bool readBinary(QJsonValue *value)
+    {
+        qint32 length;
+        // Length excludes the subtype byte
+        if (!readNumber(&length) || length < 0 || end - cur < (ptrdiff_t)length + 1) {
+            return false;
+        }
+        cur++;
+        *value = QString::fromLatin1(QByteArray::fromRawData(cur, length).toBase64());
+        cur += length;
+        return true;
+    }
+
+    bool readDocument(QJsonObject *object, QJsonArray *array)
+    {
+        auto start = cur;
+        qint32 size;
+        if (!readNumber(&size) || size < 5 || end - start < size || start[size - 1] != '\0') {
+            return false;
+        }
+
+        // Elements must not run over the document
+        auto outerEnd = end;
+        end = start + size - 1;
+        while (cur < end) {
+            auto type = (quint8)*cur++;
+            QString key;
+            QJsonValue value;
+            if (!readKey(&key) || !readValue(type, &value)) {
+                return false;
+            }
+            if (array) {
+                // Keys of array elements are indexes in order
+                array->append(value);
+            } else {
+                object->insert(key, value);
+            }
+        }
+        // Skip the terminator
+        cur = end + 1;
+        end = outerEnd;
+        return true;
+    }
+
+    bool readValue(quint8 type, QJsonValue *value)
+    {
+        switch (type) {
+        case 0x01: { // double
+            quint64 bits;
+            if (!readNumber(&bits)) {
+                return false;
+            }
+            double number;
+            memcpy(&number, &bits, sizeof(number));
+            *value = number;
+            return true;
+        }
+        case 0x02: // string
+            return readString(value);
+        case 0x03: { // document
+            QJsonObject object;
+            if (!readDocument(&object, nullptr)) {
+                return false;
+            }
+            *value = object;
+            return true;
+        }
+        case 0x04: { // array
+            QJsonArray array;
+            if (!readDocument(nullptr, &array)) {
+                return false;
+            }
+            *value = array;
+            return true;
+        }
+        case 0x05: // binary
+            return readBinary(value);
+        case 0x07: { // ObjectId
+            if (end - cur < 12) {
+                return false;
+            }
+            *value = QString::fromLatin1(QByteArray::fromRawData(cur, 12).toHex());
+            cur += 12;
+            return true;
+        }
+        case 0x08: // boolean
+            if (end - cur < 1) {
+                return false;
+            }
+            *value = *cur++ != 0;
+            return true;
+        case 0x09: { // UTC datetime (milliseconds since epoch)
+            qint64 msecs;
+            if (!readNumber(&msecs)) {
+                return false;
+            }
+            *value = QDateTime::fromMSecsSinceEpoch(msecs, QTimeZone::utc()).toString(Qt::ISODateWithMs);
+            return true;
+        }
+        case 0x06: // undefined (deprecated)
+        case 0x0A: // null
+            *value = QJsonValue();
+            return true;
+        case 0x10: { // int32
+            qint32 number;
+            if (!readNumber(&number)) {
+                return false;
+            }
+            *value = number;
+            return true;
+        }
+        case 0x11: // timestamp
+        case 0x12: { // int64
+            qint64 number;
+            if (!readNumber(&number)) {
+                return false;
+            }
+            *value = number;
+            return true;
+        }
+        default:
+            // Regular expression, JavaScript code, decimal128, etc. are not used by the server
+            return false;
+        }
+    }
+
+public:
+    // Returns false if the message is malformed or contains unsupported types
+    static bool decode(const QByteArray &bytes, QJsonObject *object)
+    {
+        BsonReader reader;
+        reader.cur = bytes.constData();
+        reader.end = bytes.constData() + bytes.size();
+        return reader.readDocument(object, nullptr) && reader.cur == reader.end;
+    }
+};
+
+WebSocketEventType SRCLinkWebSocketClient::toEventType(const QString &event)
 {
-    UNUSED_PARAMETER(elapsedTime);
-    API_LOG("Pong received: %llu", elapsedTime);
+    static const QHash<QString, WebSocketEventType> eventTypes = {
+        {"ready", WEBSOCKET_EVENT_READY},
+        {"aborted", WEBSOCKET_EVENT_ABORTED},
+        {"added", WEBSOCKET_EVENT_ADDED},
+        {"changed", WEBSOCKET_EVENT_CHANGED},
+        {"removed", WEBSOCKET_EVENT_REMOVED},
+        {"subscribed", WEBSOCKET_EVENT_SUBSCRIBED},
+        {"unsubscribed", WEBSOCKET_EVENT_UNSUBSCRIBED},
+        {"invoked", WEBSOCKET_EVENT_INVOKED},
+        {"subscribe_failed", WEBSOCKET_EVENT_SUBSCRIBE_FAILED},
+        {"unsubscribe_failed", WEBSOCKET_EVENT_UNSUBSCRIBE_FAILED},
+        {"invoke_failed", WEBSOCKET_EVENT_INVOKE_FAILED},
+        {"error", WEBSOCKET_EVENT_ERROR},
+    };
+    return eventTypes.value(event, WEBSOCKET_EVENT_UNKNOWN);
 }
 
 void SRCLinkWebSocketClient::onTextMessageReceived(QString message)
 {
-    WebSocketMessage messageObj = QJsonDocument::fromJson(message.toUtf8()).object();
-    if (messageObj.getEvent() == "ready") {
+    dispatch(QJsonDocument::fromJson(message.toUtf8()).object());
+}
+
+// Returns false if the envelope is malformed or unconfirmed, the message is passed through if not enveloped
+bool SRCLinkWebSocketClient::decompress(const QByteArray &envelope, QByteArray &message)
+{
+    if (envelope.size() < ENVELOPE_HEADER_SIZE || !envelope.startsWith(QByteArray(ENVELOPE_MAGIC_SIZE, '\0'))) {
+        message = envelope;
+        return true;
+    }
+    // Envelopes are unexpected unless the server has confirmed compression
+    if (!hasServerCapability(WEBSOCKET_CAPABILITY_COMPRESSION) ||
+        envelope[ENVELOPE_MAGIC_SIZE] != ENVELOPE_METHOD_DEFLATE) {
+        return false;
+    }
+
+    auto startedAt = os_gettime_ns();
+    message = qUncompress(
+        reinterpret_cast<const uchar *>(envelope.constData()) + ENVELOPE_HEADER_SIZE,
+        envelope.size() - ENVELOPE_HEADER_SIZE
+    );
+    if (message.isEmpty()) {
+        return false;
+    }
+
+    decompressionNsecs += os_gettime_ns() - startedAt;
+    compressedBytes += envelope.size();
+    decompressedBytes += message.size();
+    return true;
+}
+
+void SRCLinkWebSocketClient::reportCompression()
+{
+    if (compressedBytes == reportedCompressedBytes) {
+        return;
+    }
+    reportedCompressedBytes = compressedBytes;
+
+    obs_log(
+        LOG_INFO, "websocket: Inbound compression: %llu -> %llu bytes (ratio %.2f), decompression %.1f ms",
+        (unsigned long long)decompressedBytes, (unsigned long long)compressedBytes,
+        (double)decompressedBytes / (double)compressedBytes, (double)decompressionNsecs / 1000000.0
+    );
+}
+
+void SRCLinkWebSocketClient::onBinaryMessageReceived(const QByteArray &envelope)
+{
+    QByteArray message;
+    if (!decompress(envelope, message)) {
+        WARNING_LOG("Malformed envelope: %lld bytes", (long long)envelope.size());
+        return;
+    }
+
+    QJsonObject decoded;
+    if (!BsonReader::decode(message, &decoded)) {
+        WARNING_LOG("Malformed binary message: %lld bytes", (long long)message.size());
+        return;
+    }
+
+    dispatch(decoded);
+}
+
+void SRCLinkWebSocketClient::dispatch(const WebSocketMessage &message)
+{
+    switch (toEventType(message.getEvent())) {
+    case WEBSOCKET_EVENT_READY:
+        serverCapabilities.clear();
+        for (const auto &capability : message.getPayload()["capabilities"].toArray()) {
+            serverCapabilities.insert(capability.toString());
+        }
+        serverReady = true;
+        reconnectBackoff.reset();
+        API_LOG(
+            "Inbound compression: %s",
+            hasServerCapability(WEBSOCKET_CAPABILITY_COMPRESSION) ? INBOUND_COMPRESSION : "none"
+        );
         emit ready(reconnectCount > 0);
-    } else if (messageObj.getEvent() == "aborted") {
-        emit aborted(messageObj.getReason());
-    } else if (messageObj.getEvent() == "added") {
-        emit added(messageObj);
-    } else if (messageObj.getEvent() == "changed") {
-        emit changed(messageObj);
-    } else if (messageObj.getEvent() == "removed") {
-        emit removed(messageObj);
-    } else if (messageObj.getEvent() == "subscribed") {
-        emit subscribed(messageObj.getName(), messageObj.getPayload());
-    } else if (messageObj.getEvent() == "unsubscribed") {
-        emit unsubscribed(messageObj.getName(), messageObj.getPayload());
-    } else if (messageObj.getEvent() == "invoked") {
-        emit invoked(messageObj.getName(), messageObj.getPayload());
-    } else if (messageObj.getEvent() == "subscribe_failed") {
-        emit subscribeFailed(messageObj.getName(), messageObj.getPayload());
-    } else if (messageObj.getEvent() == "unsubscribe_failed") {
-        emit unsubscribeFailed(messageObj.getName(), messageObj.getPayload());
-    } else if (messageObj.getEvent() == "invoke_failed") {
-        emit invokeFailed(messageObj.getName(), messageObj.getPayload());
-    } else if (messageObj.getEvent() == "error") {
-        emit error(messageObj.getReason());
-    } else {
-        WARNING_LOG("Unknown message: %s", qUtf8Printable(message));
+        flushOutboundQueue();
+        break;
+    case WEBSOCKET_EVENT_ABORTED:
+        emit aborted(message.getReason());
+        break;
+    case WEBSOCKET_EVENT_ADDED:
+        emit added(message);
+        break;
+    case WEBSOCKET_EVENT_CHANGED:
+        emit changed(message);
+        break;
+    case WEBSOCKET_EVENT_REMOVED:
+        emit removed(message);
+        break;
+    case WEBSOCKET_EVENT_SUBSCRIBED:
+        emit subscribed(message.getName(), message.getPayload());
+        break;
+    case WEBSOCKET_EVENT_UNSUBSCRIBED:
+        emit unsubscribed(message.getName(), message.getPayload());
+        break;
+    case WEBSOCKET_EVENT_INVOKED:
+        emit invoked(message.getName(), message.getPayload());
+        break;
+    case WEBSOCKET_EVENT_SUBSCRIBE_FAILED:
+        emit subscribeFailed(message.getName(), message.getPayload());
+        break;
+    case WEBSOCKET_EVENT_UNSUBSCRIBE_FAILED:
+        emit unsubscribeFailed(message.getName(), message.getPayload());
+        break;
+    case WEBSOCKET_EVENT_INVOKE_FAILED:
+        emit invokeFailed(message.getName(), message.getPayload());
+        break;
+    case WEBSOCKET_EVENT_ERROR:
+        emit error(message.getReason());
+        break;
+    default:
+        WARNING_LOG("Unknown message: %s", qUtf8Printable(message.getEvent()));
+        break;
     }
 }
 
@@ -139,7 +464,14 @@ void SRCLinkWebSocketClient::open()
         return;
     }
 
-    auto req = QNetworkRequest(url);
+    // Request binary frames for server -> client messages
+    auto wsUrl = url;
+    QUrlQuery query(wsUrl);
+    query.addQueryItem("encoding", INBOUND_ENCODING);
+    query.addQueryItem("compression", INBOUND_COMPRESSION);
+    wsUrl.setQuery(query);
+
+    auto req = QNetworkRequest(wsUrl);
     req.setRawHeader("Authorization", QString("Bearer %1").arg(apiClient->getAccessToken()).toLatin1());
 
     client->open(req);
@@ -154,6 +486,7 @@ void SRCLinkWebSocketClient::start()
     API_LOG("Connecting: %s", qUtf8Printable(url.toString()));
     started = true;
     reconnectCount = 0;
+    reconnectBackoff.reset();
     open();
 }
 
@@ -165,6 +498,9 @@ void SRCLinkWebSocketClient::stop()
 
     API_LOG("Disconnecting");
     started = false;
+    serverReady = false;
+    reconnectTimer->stop();
+    outboundQueue.clear();
     client->close();
 }
 
@@ -200,27 +536,100 @@ void SRCLinkWebSocketClient::unsubscribe(const QString &name, const QJsonObject
     client->sendTextMessage(QJsonDocument(message).toJson(QJsonDocument::Compact));
 }
 
-void SRCLinkWebSocketClient::invokeBin(const QString &name, const json &payload)
+void SRCLinkWebSocketClient::invokeBin(
+    const QString &name, json &&payload, OutboundPriority priority, const QString &coalesceKey
+)
 {
-    if (!started || !client->isValid()) {
+    if (!started) {
         return;
     }
 
-    API_LOG("Invoke(bin): %s", qUtf8Printable(name));
+    sendBin(name, encodeInvokeBin(name, std::move(payload)), priority, coalesceKey);
+}
 
+QByteArray SRCLinkWebSocketClient::encodeInvokeBin(const QString &name, json &&payload)
+{
     json message;
 
     message["event"] = "invoke";
     message["name"] = qUtf8Printable(name);
-    message["payload"] = payload;
+    message["payload"] = std::move(payload);
+
+    // Reuse the encode buffer of each thread to avoid reallocation per message
+    thread_local std::vector<std::uint8_t> buffer;
+    buffer.clear();
+    json::to_bson(message, buffer);
+    return QByteArray(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+}
+
+void SRCLinkWebSocketClient::sendBin(
+    const QString &name, const QByteArray &message, OutboundPriority priority, const QString &coalesceKey
+)
+{
+    if (!started) {
+        return;
+    }
+
+    if (!serverReady || !client->isValid()) {
+        enqueue({name, coalesceKey, message, priority});
+        return;
+    }
+
+    API_LOG("Invoke(bin): %s", qUtf8Printable(name));
 
-    auto bson = json::to_bson(message);
-    auto sent = client->sendBinaryMessage(QByteArray(reinterpret_cast<const char *>(bson.data()), bson.size()));
+    auto sent = client->sendBinaryMessage(message);
 
     UNUSED_PARAMETER(sent);
     API_LOG("Invoke(bin): %lld bytes sent", sent);
 }
 
+void SRCLinkWebSocketClient::enqueue(const OutboundMessage &message)
+{
+    if (!message.coalesceKey.isEmpty()) {
+        for (auto &queued : outboundQueue) {
+            if (queued.coalesceKey == message.coalesceKey) {
+                // Last value wins
+                queued = message;
+                return;
+            }
+        }
+    }
+
+    outboundQueue.append(message);
+
+    if (outboundQueue.size() > OUTBOUND_QUEUE_MAX_SIZE) {
+        // Drop the oldest one of the lowest priority
+        auto victim = outboundQueue.begin();
+        for (auto it = outboundQueue.begin(); it != outboundQueue.end(); it++) {
+            if (it->priority > victim->priority) {
+                victim = it;
+            }
+        }
+        WARNING_LOG("Outbound queue is full, dropped: %s", qUtf8Printable(victim->name));
+        outboundQueue.erase(victim);
+    }
+
+    API_LOG("Queued(bin): %s, size=%lld", qUtf8Printable(message.name), (long long)outboundQueue.size());
+}
+
+void SRCLinkWebSocketClient::flushOutboundQueue()
+{
+    if (outboundQueue.isEmpty()) {
+        return;
+    }
+
+    auto queue = outboundQueue;
+    outboundQueue.clear();
+    std::stable_sort(queue.begin(), queue.end(), [](const OutboundMessage &a, const OutboundMessage &b) {
+        return a.priority < b.priority;
+    });
+
+    API_LOG("Flushing %lld queued messages", (long long)queue.size());
+    for (const auto &message : queue) {
+        sendBin(message.name, message.data, message.priority, message.coalesceKey);
+    }
+}
+
 void SRCLinkWebSocketClient::invokeText(const QString &name, const QJsonObject &payload)
 {
     if (!started || !client->isValid()) {
@@ -22,14 +22,46 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #include <QWebSocket>
 #include <QJsonObject>
 #include <QTimer>
+#include <QSet>
 
 #include <nlohmann/json.hpp>
 using json = nlohmann::json;
 
 #include "schema.hpp"
+#include "reconnect-backoff.hpp"
+#include "link-health-monitor.hpp"
 
 class SRCLinkApiClient;
 
+enum OutboundPriority {
+    OUTBOUND_PRIORITY_HIGH,
+    OUTBOUND_PRIORITY_NORMAL,
+    OUTBOUND_PRIORITY_LOW,
+};
+
+struct OutboundMessage {
+    QString name;
+    QString coalesceKey; // Newer message replaces queued one with the same key
+    QByteArray data;
+    OutboundPriority priority;
+};
+
+enum WebSocketEventType {
+    WEBSOCKET_EVENT_UNKNOWN,
+    WEBSOCKET_EVENT_READY,
+    WEBSOCKET_EVENT_ABORTED,
+    WEBSOCKET_EVENT_ADDED,
+    WEBSOCKET_EVENT_CHANGED,
+    WEBSOCKET_EVENT_REMOVED,
+    WEBSOCKET_EVENT_SUBSCRIBED,
+    WEBSOCKET_EVENT_UNSUBSCRIBED,
+    WEBSOCKET_EVENT_INVOKED,
+    WEBSOCKET_EVENT_SUBSCRIBE_FAILED,
+    WEBSOCKET_EVENT_UNSUBSCRIBE_FAILED,
+    WEBSOCKET_EVENT_INVOKE_FAILED,
+    WEBSOCKET_EVENT_ERROR,
+};
+
 class SRCLinkWebSocketClient : public QObject {
     Q_OBJECT
 
@@ -37,10 +69,28 @@ class SRCLinkWebSocketClient : public QObject {
     QWebSocket *client;
     SRCLinkApiClient *apiClient;
     bool started;
+    bool serverReady;
+    QSet<QString> serverCapabilities; // Announced by the server in "ready"
     int reconnectCount;
+    ReconnectBackoff reconnectBackoff;
+    QTimer *reconnectTimer;
     QTimer *intervalTimer;
+    LinkHealthMonitor *healthMonitor;
+    QList<OutboundMessage> outboundQueue; // Held until the server gets ready
+    // Statistics of compressed inbound frames
+    uint64_t compressedBytes;
+    uint64_t decompressedBytes;
+    uint64_t decompressionNsecs;
+    uint64_t reportedCompressedBytes;
 
     void open();
+    bool decompress(const QByteArray &envelope, QByteArray &message);
+    void reportCompression();
+    void enqueue(const OutboundMessage &message);
+    void flushOutboundQueue();
+    void dispatch(const WebSocketMessage &message);
+
+    static WebSocketEventType toEventType(const QString &event);
 
 signals:
     void ready(bool reconect);
@@ -62,15 +112,32 @@ signals:
 private slots:
     void onConnected();
     void onDisconnected();
-    void onPong(quint64 elapsedTime, const QByteArray &payload);
     void onTextMessageReceived(QString message);
+    void onBinaryMessageReceived(const QByteArray &envelope);
 
 public:
     explicit SRCLinkWebSocketClient(QUrl wsUrl, SRCLinkApiClient *apiClient, QObject *parent = nullptr);
     ~SRCLinkWebSocketClient();
 
     // Do not place slots
-    void invokeBin(const QString &name, const json &payload = json());
+    // Messages are queued while disconnected and sent when the server gets ready
+    void invokeBin(
+        const QString &name, json &&payload = json(), OutboundPriority priority = OUTBOUND_PRIORITY_NORMAL,
+        const QString &coalesceKey = QString()
+    );
+    // Sends the message encoded by encodeInvokeBin()
+    void sendBin(
+        const QString &name, const QByteArray &message, OutboundPriority priority = OUTBOUND_PRIORITY_NORMAL,
+        const QString &coalesceKey = QString()
+    );
+
+    // Thread-safe, heavy payloads can be encoded on worker threads
+    // The payload is moved into the message
+    static QByteArray encodeInvokeBin(const QString &name, json &&payload = json());
+
+    inline LinkHealthMonitor *getHealthMonitor() const { return healthMonitor; }
+    inline bool isServerReady() const { return serverReady; }
+    inline bool hasServerCapability(const QString &name) const { return serverCapabilities.contains(name); }
 
 public slots:
     void start();
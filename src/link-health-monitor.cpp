@@ -0,0 +1,196 @@
+/*
+SRC-Link
+Copyright (C) 2024 OPENSPHERE Inc. info@opensphere.co.jp
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <obs-module.h>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+#include "plugin-support.h"
+#include "link-health-monitor.hpp"
+
+#define LINK_HEALTH_REPORT_INTERVAL_MSECS 60000
+
+//--- LinkHealthMonitor class ---//
+
+LinkHealthMonitor::LinkHealthMonitor(const QString &_label, int pingIntervalMsecs, QObject *parent)
+    : QObject(parent),
+      label(_label),
+      awaitingPong(false),
+      missedPongs(0),
+      halfOpenCount(0),
+      lastRtt(-1),
+      minRtt(-1),
+      maxRtt(-1),
+      rttSum(0),
+      sampleCount(0)
+{
+    std::fill_n(histogram, LINK_HEALTH_BUCKETS, 0);
+
+    pingTimer = new QTimer(this);
+    connect(pingTimer, SIGNAL(timeout()), this, SLOT(onPingTimerTimeout()));
+    pingTimer->setInterval(std::max(pingIntervalMsecs, 1000));
+    pingTimer->start();
+
+    reportTimer = new QTimer(this);
+    connect(reportTimer, SIGNAL(timeout()), this, SLOT(onReportTimerTimeout()));
+    reportTimer->setInterval(LINK_HEALTH_REPORT_INTERVAL_MSECS);
+    reportTimer->start();
+}
+
+LinkHealthMonitor::~LinkHealthMonitor()
+{
+    detach();
+}
+
+void LinkHealthMonitor::attach(QWebSocket *_socket)
+{
+    detach();
+
+    socket = _socket;
+    if (socket) {
+        connect(socket, SIGNAL(pong(quint64, const QByteArray &)), this, SLOT(onPong(quint64, const QByteArray &)));
+    }
+}
+
+void LinkHealthMonitor::detach()
+{
+    if (socket) {
+        socket->disconnect(this);
+    }
+    socket = nullptr;
+    awaitingPong = false;
+    missedPongs = 0;
+}
+
+void LinkHealthMonitor::onPingTimerTimeout()
+{
+    if (!socket || !socket->isValid()) {
+        awaitingPong = false;
+        missedPongs = 0;
+        return;
+    }
+
+    if (awaitingPong) {
+        // Don't ping again, the elapsed time of a late pong is measured from the last ping
+        missedPongs++;
+        if (missedPongs >= LINK_HEALTH_MAX_MISSED_PONGS) {
+            obs_log(LOG_WARNING, "link-health: %s: No pong for %d pings, aborting", qUtf8Printable(label), missedPongs);
+            halfOpenCount++;
+            awaitingPong = false;
+            missedPongs = 0;
+            emit unresponsive();
+            emit healthUpdated(getHealth());
+        }
+        return;
+    }
+
+    awaitingPong = true;
+    socket->ping();
+}
+
+void LinkHealthMonitor::onPong(quint64 elapsedTime, const QByteArray &)
+{
+    if (!awaitingPong) {
+        // Pong of the ping sent by someone else
+        return;
+    }
+
+    awaitingPong = false;
+    missedPongs = 0;
+    addSample((int)std::min(elapsedTime, (quint64)INT_MAX));
+
+    emit healthUpdated(getHealth());
+}
+
+void LinkHealthMonitor::addSample(int rtt)
+{
+    lastRtt = rtt;
+    minRtt = minRtt < 0 ? rtt : std::min(minRtt, rtt);
+    maxRtt = std::max(maxRtt, rtt);
+    rttSum += rtt;
+    sampleCount++;
+    histogram[std::min(rtt / LINK_HEALTH_BUCKET_MSECS, LINK_HEALTH_BUCKETS - 1)]++;
+}
+
+// Returns the upper bound of the bucket which contains the percentile
+int LinkHealthMonitor::percentile(double ratio) const
+{
+    if (!sampleCount) {
+        return -1;
+    }
+
+    auto rank = (uint32_t)std::ceil(sampleCount * ratio);
+    uint32_t accumulated = 0;
+    for (int i = 0; i < LINK_HEALTH_BUCKETS - 1; i++) {
+        accumulated += histogram[i];
+        if (accumulated >= rank) {
+            return std::min((i + 1) * LINK_HEALTH_BUCKET_MSECS, maxRtt);
+        }
+    }
+    return maxRtt;
+}
+
+const LinkHealth LinkHealthMonitor::getHealth() const
+{
+    LinkHealth health;
+    health.lastRtt = lastRtt;
+    health.minRtt = minRtt;
+    health.maxRtt = maxRtt;
+    health.avgRtt = sampleCount ? rttSum / sampleCount : 0;
+    health.p99Rtt = percentile(0.99);
+    health.samples = sampleCount;
+    health.missedPongs = missedPongs;
+    health.halfOpenCount = halfOpenCount;
+    return health;
+}
+
+void LinkHealthMonitor::onReportTimerTimeout()
+{
+    if (!sampleCount) {
+        return;
+    }
+
+    auto health = getHealth();
+    obs_log(
+        LOG_INFO, "link-health: %s: rtt=%d ms, min=%d ms, avg=%.1f ms, p99=%d ms, samples=%d, half-open=%d",
+        qUtf8Printable(label), health.lastRtt, health.minRtt, health.avgRtt, health.p99Rtt, health.samples,
+        health.halfOpenCount
+    );
+
+    // Decay the histogram to follow changes of the network, min/max are approximated by the remaining buckets
+    sampleCount = 0;
+    auto lowest = -1;
+    auto highest = -1;
+    for (int i = 0; i < LINK_HEALTH_BUCKETS; i++) {
+        histogram[i] /= 2;
+        if (histogram[i]) {
+            lowest = lowest < 0 ? i : lowest;
+            highest = i;
+        }
+        sampleCount += histogram[i];
+    }
+    rttSum = health.avgRtt * sampleCount;
+    minRtt = lowest < 0 ? -1 : lowest * LINK_HEALTH_BUCKET_MSECS;
+    if (highest < 0) {
+        maxRtt = -1;
+    } else if (highest < LINK_HEALTH_BUCKETS - 1) {
+        maxRtt = (highest + 1) * LINK_HEALTH_BUCKET_MSECS - 1;
+    }
+}
@@ -0,0 +1,85 @@
+/*
+SRC-Link
+Copyright (C) 2024 OPENSPHERE Inc. info@opensphere.co.jp
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QWebSocket>
+
+#define LINK_HEALTH_DEFAULT_PING_INTERVAL_MSECS 5000
+#define LINK_HEALTH_MAX_MISSED_PONGS 3
+#define LINK_HEALTH_BUCKET_MSECS 5
+#define LINK_HEALTH_BUCKETS 200 // Covers up to 1 second, the last bucket holds overflows
+
+struct LinkHealth {
+    int lastRtt = -1; // milliseconds, -1 if never sampled
+    int minRtt = -1;
+    int maxRtt = -1;
+    double avgRtt = 0;
+    int p99Rtt = -1;
+    int samples = 0;
+    int missedPongs = 0;   // Consecutive pings not answered yet
+    int halfOpenCount = 0; // Connections aborted due to missing pongs
+};
+
+// Samples RTT of WebSocket ping/pong and detects half-open connections before TCP notices.
+// Percentiles are calculated from a fixed-size histogram which decays on each report.
+class LinkHealthMonitor : public QObject {
+    Q_OBJECT
+
+    QString label;
+    QPointer<QWebSocket> socket;
+    QTimer *pingTimer;
+    QTimer *reportTimer;
+    bool awaitingPong;
+    int missedPongs;
+    int halfOpenCount;
+    int lastRtt;
+    int minRtt;
+    int maxRtt;
+    double rttSum;
+    uint32_t sampleCount;
+    uint32_t histogram[LINK_HEALTH_BUCKETS];
+
+    void addSample(int rtt);
+    int percentile(double ratio) const;
+
+signals:
+    void healthUpdated(const LinkHealth &health);
+    // The socket should be aborted to reconnect
+    void unresponsive();
+
+private slots:
+    void onPingTimerTimeout();
+    void onReportTimerTimeout();
+    void onPong(quint64 elapsedTime, const QByteArray &payload);
+
+public:
+    explicit LinkHealthMonitor(
+        const QString &_label, int pingIntervalMsecs = LINK_HEALTH_DEFAULT_PING_INTERVAL_MSECS,
+        QObject *parent = nullptr
+    );
+    ~LinkHealthMonitor();
+
+    // The socket can be replaced at any time, samples are kept across sockets
+    void attach(QWebSocket *_socket);
+    void detach();
+    const LinkHealth getHealth() const;
+};
@@ -0,0 +1,160 @@
+/*
+SRC-Link
+Copyright (C) 2024 OPENSPHERE Inc. info@opensphere.co.jp
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define AUDIO_MIX_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+#define AUDIO_MIX_NEON
+#include <arm_neon.h>
+#endif
+
+#include "audio-mix.hpp"
+
+static void mixScalar(float *out, const float *in, size_t frames)
+{
+    // Branchless clamp, compiler emits minss/maxss or fmin/fmax
+    for (size_t i = 0; i < frames; i++) {
+        out[i] = std::min(std::max(out[i] + in[i], -1.0f), 1.0f);
+    }
+}
+
+#ifdef AUDIO_MIX_X86
+static void mixSse2(float *out, const float *in, size_t frames)
+{
+    const auto lo = _mm_set1_ps(-1.0f);
+    const auto hi = _mm_set1_ps(1.0f);
+
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        auto v = _mm_add_ps(_mm_loadu_ps(out + i), _mm_loadu_ps(in + i));
+        _mm_storeu_ps(out + i, _mm_min_ps(_mm_max_ps(v, lo), hi));
+    }
+    mixScalar(out + i, in + i, frames - i);
+}
+
+TARGET_AVX2 static void mixAvx2(float *out, const float *in, size_t frames)
+{
+    const auto lo = _mm256_set1_ps(-1.0f);
+    const auto hi = _mm256_set1_ps(1.0f);
+
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        auto v = _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_loadu_ps(in + i));
+        _mm256_storeu_ps(out + i, _mm256_min_ps(_mm256_max_ps(v, lo), hi));
+    }
+    mixScalar(out + i, in + i, frames - i);
+}
+
+static bool hasAvx2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    // OSXSAVE and AVX, then check OS saves YMM state
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) {
+        return false;
+    }
+    if ((_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+#ifdef AUDIO_MIX_NEON
+static void mixNeon(float *out, const float *in, size_t frames)
+{
+    const auto lo = vdupq_n_f32(-1.0f);
+    const auto hi = vdupq_n_f32(1.0f);
+
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        auto v = vaddq_f32(vld1q_f32(out + i), vld1q_f32(in + i));
+        vst1q_f32(out + i, vminq_f32(vmaxq_f32(v, lo), hi));
+    }
+    mixScalar(out + i, in + i, frames - i);
+}
+#endif
+
+static AudioMixKernelEntry selectKernel()
+{
+#if defined(AUDIO_MIX_X86)
+    if (hasAvx2()) {
+        return {mixAvx2, "avx2"};
+    }
+    // SSE2 is baseline on x86_64
+    return {mixSse2, "sse2"};
+#elif defined(AUDIO_MIX_NEON)
+    return {mixNeon, "neon"};
+#else
+    return {mixScalar, "scalar"};
+#endif
+}
+
+static const AudioMixKernelEntry &getKernel()
+{
+    static const AudioMixKernelEntry entry = selectKernel();
+    return entry;
+}
+
+void mixAudioClamped(float *out, const float *in, size_t frames)
+{
+    getKernel().kernel(out, in, frames);
+}
+
+const char *getAudioMixKernelName()
+{
+    return getKernel().name;
+}
+
+size_t getAudioMixKernels(AudioMixKernelEntry *entries, size_t capacity)
+{
+    AudioMixKernelEntry available[4];
+    size_t count = 0;
+#if defined(AUDIO_MIX_X86)
+    if (hasAvx2()) {
+        available[count++] = {mixAvx2, "avx2"};
+    }
+    available[count++] = {mixSse2, "sse2"};
+#elif defined(AUDIO_MIX_NEON)
+    available[count++] = {mixNeon, "neon"};
+#endif
+    available[count++] = {mixScalar, "scalar"};
+
+    count = std::min(count, capacity);
+    std::copy(available, available + count, entries);
+    return count;
+}
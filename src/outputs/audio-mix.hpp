@@ -0,0 +1,35 @@
+/*
+SRC-Link
+Copyright (C) 2024 OPENSPHERE Inc. info@opensphere.co.jp
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stddef.h>
+
+typedef void (*AudioMixKernel)(float *out, const float *in, size_t frames);
+
+struct AudioMixKernelEntry {
+    AudioMixKernel kernel;
+    const char *name;
+};
+
+// Accumulates in[] into out[] and clamps the result to [-1.0, 1.0].
+// The fastest kernel for the running CPU (AVX2/SSE2/NEON/scalar) is selected at first call.
+void mixAudioClamped(float *out, const float *in, size_t frames);
+const char *getAudioMixKernelName();
+// Lists every kernel usable on the running CPU, fastest first and scalar last (for benchmarks)
+size_t getAudioMixKernels(AudioMixKernelEntry *entries, size_t capacity);
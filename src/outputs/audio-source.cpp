@@ -16,16 +16,60 @@ You should have received a copy of the GNU General Public License along
 with this program. If not, see <https://www.gnu.org/licenses/>
 */
 
+#include <util/util_uint64.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "../plugin-support.h"
+#include "audio-mix.hpp"
 #include "audio-source.hpp"
 
+#define AUDIO_DRIFT_MAX_RATIO 0.005 // +/-0.5%
+#define AUDIO_DRIFT_GAIN 0.01
+#define AUDIO_DRIFT_DEADBAND 0.1 // Relative to target latency
+#define AUDIO_DRIFT_SMOOTHING 0.05
+#define AUDIO_OVERRUN_FACTOR 3
+#define AUDIO_TS_ALIGN_TOLERANCE_NSECS 40000000LL // Smaller errors are absorbed by the resampler
+#define AUDIO_TS_RESYNC_THRESHOLD_NSECS 1000000000LL // Larger errors mean a new source timeline
+
+static void resampleLinear(float *out, const float *in, size_t frames, double phase, double ratio)
+{
+    for (size_t i = 0; i < frames; i++) {
+        auto pos = phase + i * ratio;
+        auto idx = (size_t)pos;
+        auto frac = (float)(pos - idx);
+        out[i] = in[idx] + (in[idx + 1] - in[idx]) * frac;
+    }
+}
+
 //--- OutputAudioSource class ---//
 
 OutputAudioSource::OutputAudioSource(
-    obs_source_t *source, uint32_t _samplesPerSec, speaker_layout _speakers, QObject *parent
+    obs_source_t *source, uint32_t _samplesPerSec, speaker_layout _speakers, int targetLatencyMsecs, QObject *parent
 )
     : SourceAudioCapture(source, _samplesPerSec, _speakers, parent),
-      audio(nullptr)
+      audio(nullptr),
+      buffering(true),
+      resampleRatio(1.0),
+      resamplePhase(0.0),
+      smoothedOccupancy(0.0),
+      tsOffset(0),
+      tsAligned(false),
+      resampleOut{nullptr}
 {
+    // At least one output tick, at most a quarter of the ring
+    targetFrames = std::clamp(
+        (size_t)util_mul_div64(std::max(targetLatencyMsecs, 0), _samplesPerSec, 1000), (size_t)AUDIO_OUTPUT_FRAMES,
+        audioRing.getCapacity() / 4
+    );
+
+    resampleIn = (float *)bzalloc(AUDIO_OUTPUT_FRAMES * 2 * sizeof(float));
+    for (size_t ch = 0; ch < std::min(audioRing.getChannels(), (size_t)MAX_AV_PLANES); ch++) {
+        resampleOut[ch] = (float *)bzalloc(AUDIO_OUTPUT_FRAMES * sizeof(float));
+    }
+
     audio_output_info aoi = {0};
     aoi.name = obs_source_get_name(source);
     aoi.samples_per_sec = _samplesPerSec;
@@ -40,6 +84,11 @@ OutputAudioSource::OutputAudioSource(
     }
 
     active = true;
+
+    obs_log(
+        LOG_DEBUG, "%s: Output audio source uses %s mix kernel, target latency %zu frames.", aoi.name,
+        getAudioMixKernelName(), targetFrames
+    );
 }
 
 OutputAudioSource::~OutputAudioSource()
@@ -49,6 +98,92 @@ OutputAudioSource::~OutputAudioSource()
     if (audio) {
         audio_output_close(audio);
     }
+
+    bfree(resampleIn);
+    for (auto buffer : resampleOut) {
+        bfree(buffer);
+    }
+}
+
+// Discards the oldest frames to bring buffer occupancy back to the target
+size_t OutputAudioSource::trimAudio(size_t readable)
+{
+    if (readable <= targetFrames) {
+        return readable;
+    }
+
+    auto excess = readable - targetFrames;
+    audioRing.consume(excess);
+    resamplePhase = 0.0;
+    smoothedOccupancy = (double)targetFrames;
+    // The head moved on purpose, take the new offset to the output tick
+    tsAligned = false;
+
+    return targetFrames;
+}
+
+// Timestamp of the frame at the read position
+uint64_t OutputAudioSource::getFrontTimestamp(const AudioRingBuffer::Chunk &chunk) const
+{
+    return chunk.timestamp + util_mul_div64(audioRing.getReadPosition() - chunk.position, 1000000000ULL, samplesPerSec);
+}
+
+// Moves the read position to the output tick: Late frames are dropped, early frames are delayed by silent ticks.
+// Returns false when this tick must be silence.
+bool OutputAudioSource::alignTimestamp(uint64_t startTsIn, size_t *readable)
+{
+    AudioRingBuffer::Chunk chunk;
+    if (!audioRing.peekChunk(&chunk)) {
+        return true;
+    }
+
+    // Positive when the buffered head is behind the output tick
+    auto lateNs = (int64_t)(startTsIn - getFrontTimestamp(chunk)) - tsOffset;
+
+    if (!tsAligned || std::llabs(lateNs) > AUDIO_TS_RESYNC_THRESHOLD_NSECS) {
+        if (tsAligned) {
+            // Source timeline jumped (seek, restart, etc.) -> Restart from the target latency
+            *readable = trimAudio(*readable);
+            audioRing.peekChunk(&chunk);
+        }
+        tsOffset = (int64_t)(startTsIn - getFrontTimestamp(chunk));
+        tsAligned = true;
+        return true;
+    }
+
+    if (std::llabs(lateNs) <= AUDIO_TS_ALIGN_TOLERANCE_NSECS) {
+        return true;
+    }
+
+    if (lateNs < 0) {
+        // Gap in the source timeline -> Insert silence until the head is due
+        return false;
+    }
+
+    // Source stalled and resumed with old timestamps -> Drop what is overdue
+    auto lateFrames = std::min((size_t)util_mul_div64((uint64_t)lateNs, samplesPerSec, 1000000000ULL), *readable);
+    audioRing.consume(lateFrames);
+    *readable -= lateFrames;
+    resamplePhase = 0.0;
+    smoothedOccupancy = (double)*readable;
+
+    return true;
+}
+
+// Proportional controller which keeps buffer occupancy around the target
+void OutputAudioSource::updateResampleRatio(size_t readable)
+{
+    smoothedOccupancy += ((double)readable - smoothedOccupancy) * AUDIO_DRIFT_SMOOTHING;
+
+    auto error = (smoothedOccupancy - (double)targetFrames) / (double)targetFrames;
+    if (std::abs(error) < AUDIO_DRIFT_DEADBAND) {
+        // Snap back to pass-through
+        resampleRatio = 1.0;
+        resamplePhase = 0.0;
+        return;
+    }
+
+    resampleRatio = 1.0 + std::clamp(error * AUDIO_DRIFT_GAIN, -AUDIO_DRIFT_MAX_RATIO, AUDIO_DRIFT_MAX_RATIO);
 }
 
 uint64_t OutputAudioSource::popAudio(uint64_t startTsIn, uint32_t mixers, audio_output_data *audioData)
@@ -57,68 +192,85 @@ uint64_t OutputAudioSource::popAudio(uint64_t startTsIn, uint32_t mixers, audio_
         return startTsIn;
     }
 
-    QMutexLocker locker(&audioBufferMutex);
-    {
-        if (audioBufferFrames < AUDIO_OUTPUT_FRAMES) {
-            // Wait until enough frames are receved.
-            // DO NOT stall audio output pipeline
+    auto readable = audioRing.getReadableFrames();
+
+    if (buffering) {
+        // Wait until target latency is filled.
+        // DO NOT stall audio output pipeline
+        if (readable < targetFrames + AUDIO_OUTPUT_FRAMES) {
             return startTsIn;
         }
+        buffering = false;
+        resamplePhase = 0.0;
+        smoothedOccupancy = (double)readable;
+    }
 
-        size_t maxFrames = AUDIO_OUTPUT_FRAMES;
-
-        while (maxFrames > 0 && audioBufferFrames) {
-            // Peek header of first chunk
-            deque_peek_front(&audioBuffer, audioConvBuffer, sizeof(AudioBufferHeader));
-            auto header = (AudioBufferHeader *)audioConvBuffer;
-            auto dataSize = sizeof(AudioBufferHeader) + header->speakers * header->frames * 4;
+    if (readable > targetFrames * AUDIO_OVERRUN_FACTOR + AUDIO_OUTPUT_FRAMES) {
+        // Too far behind for the resampler to catch up
+        readable = trimAudio(readable);
+    }
+    if (!alignTimestamp(startTsIn, &readable)) {
+        return startTsIn;
+    }
+    updateResampleRatio(readable);
 
-            // Read chunk data
-            deque_peek_front(&audioBuffer, audioConvBuffer, dataSize);
+    // Interpolation reads one frame beyond the last position
+    auto needed = (size_t)(resamplePhase + (AUDIO_OUTPUT_FRAMES - 1) * resampleRatio) + 2;
+    if (readable < needed) {
+        // Underrun (muted or stalled source) -> Output silence and rebuffer
+        buffering = true;
+        return startTsIn;
+    }
 
-            auto chunkFrames = header->frames - header->offset;
-            auto frames = (chunkFrames > maxFrames) ? maxFrames : chunkFrames;
-            auto outOffset = AUDIO_OUTPUT_FRAMES - maxFrames;
+    auto channels = std::min(audioRing.getChannels(), (size_t)MAX_AV_PLANES);
 
-            for (auto tr = 0; tr < MAX_AUDIO_MIXES; tr++) {
-                if ((mixers & (1 << tr)) == 0) {
-                    continue;
-                }
-                for (auto ch = 0; ch < header->speakers; ch++) {
-                    auto out = audioData[tr].data[ch] + outOffset;
-                    if (!header->data_idx[ch]) {
-                        continue;
-                    }
-                    auto in = (float *)(audioConvBuffer + header->data_idx[ch]) + header->offset;
-
-                    for (size_t i = 0; i < frames; i++) {
-                        *out += *(in++);
-                        if (*out > 1.0f) {
-                            *out = 1.0f;
-                        } else if (*out < -1.0f) {
-                            *out = -1.0f;
-                        }
-                        out++;
-                    }
+    if (resampleRatio == 1.0 && resamplePhase == 0.0) {
+        // Pass-through: Mix straight from the ring (It wraps at most once)
+        for (auto tr = 0; tr < MAX_AUDIO_MIXES; tr++) {
+            if ((mixers & (1 << tr)) == 0) {
+                continue;
+            }
+            for (size_t ch = 0; ch < channels; ch++) {
+                size_t outOffset = 0;
+                while (outOffset < AUDIO_OUTPUT_FRAMES) {
+                    size_t frames = 0;
+                    auto in = audioRing.peek(ch, outOffset, &frames);
+                    frames = std::min(frames, (size_t)AUDIO_OUTPUT_FRAMES - outOffset);
+                    mixAudioClamped(audioData[tr].data[ch] + outOffset, in, frames);
+                    outOffset += frames;
                 }
             }
+        }
 
-            if (frames == chunkFrames) {
-                // Remove fulfilled chunk from buffer
-                deque_pop_front(&audioBuffer, NULL, dataSize);
-            } else {
-                // Chunk frames are remaining -> modify chunk header
-                header->offset += frames;
-                deque_place(&audioBuffer, 0, header, sizeof(AudioBufferHeader));
+    } else {
+        // Resample each channel once, then mix it into every track
+        for (size_t ch = 0; ch < channels; ch++) {
+            size_t copied = 0;
+            while (copied < needed) {
+                size_t frames = 0;
+                auto in = audioRing.peek(ch, copied, &frames);
+                frames = std::min(frames, needed - copied);
+                memcpy(resampleIn + copied, in, frames * sizeof(float));
+                copied += frames;
             }
+            resampleLinear(resampleOut[ch], resampleIn, AUDIO_OUTPUT_FRAMES, resamplePhase, resampleRatio);
+        }
 
-            maxFrames -= frames;
-
-            // Decrement buffer usage
-            audioBufferFrames -= frames;
+        for (auto tr = 0; tr < MAX_AUDIO_MIXES; tr++) {
+            if ((mixers & (1 << tr)) == 0) {
+                continue;
+            }
+            for (size_t ch = 0; ch < channels; ch++) {
+                mixAudioClamped(audioData[tr].data[ch], resampleOut[ch], AUDIO_OUTPUT_FRAMES);
+            }
         }
     }
-    locker.unlock();
+
+    auto advance = resamplePhase + AUDIO_OUTPUT_FRAMES * resampleRatio;
+    auto consumed = (size_t)advance;
+    resamplePhase = advance - consumed;
+
+    audioRing.consume(consumed);
 
     return startTsIn;
 }
@@ -27,17 +27,36 @@ class OutputAudioSource : public SourceAudioCapture {
 
     audio_t *audio;
 
+    // Drift compensation state (touched by audio output thread only)
+    size_t targetFrames;
+    bool buffering;
+    double resampleRatio;
+    double resamplePhase;
+    double smoothedOccupancy;
+    // Output tick timestamp minus buffered head timestamp, captured when the first buffering completed
+    int64_t tsOffset;
+    bool tsAligned;
+    float *resampleIn;
+    float *resampleOut[MAX_AV_PLANES];
+
     static bool onOutputAudio(
         void *param, uint64_t startTsIn, uint64_t, uint64_t *outTs, uint32_t mixers, audio_output_data *audioData
     );
 
+    size_t trimAudio(size_t readable);
+    uint64_t getFrontTimestamp(const AudioRingBuffer::Chunk &chunk) const;
+    bool alignTimestamp(uint64_t startTsIn, size_t *readable);
+    void updateResampleRatio(size_t readable);
+
 public:
     explicit OutputAudioSource(
-        obs_source_t *source, uint32_t _samplesPerSec, speaker_layout _speakers, QObject *parent = nullptr
+        obs_source_t *source, uint32_t _samplesPerSec, speaker_layout _speakers, int targetLatencyMsecs,
+        QObject *parent = nullptr
     );
     ~OutputAudioSource();
 
     inline audio_t *getAudio() { return audio; }
+    inline double getResampleRatio() const { return resampleRatio; }
 
     uint64_t popAudio(uint64_t startTsIn, uint32_t mixers, audio_output_data *audioData);
 };
@@ -0,0 +1,125 @@
+/*
+SRC-Link
+Copyright (C) 2024 OPENSPHERE Inc. info@opensphere.co.jp
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <algorithm>
+
+#include "bitrate-controller.hpp"
+
+#define ABR_DROP_RATIO_THRESHOLD 0.02   // Back off when more than 2% of frames are dropped
+#define ABR_CONGESTION_THRESHOLD 0.5    // Back off when output congestion exceeds this level
+#define ABR_CONGESTION_HEALTHY 0.1      // Link is considered healthy below this level
+#define ABR_DECREASE_FACTOR 0.75        // Multiplicative decrease
+#define ABR_THROUGHPUT_FACTOR 0.9       // Never exceed measured throughput right after backing off
+#define ABR_INCREASE_STEP_RATIO 0.05    // Additive increase (Ratio of ceiling)
+#define ABR_HEALTHY_TICKS 5             // Ticks to be healthy before increasing
+#define ABR_COOLDOWN_TICKS 3            // Ticks to wait after decreasing (Let the encoder settle)
+#define ABR_FLOOR_RATIO 0.25            // Used when the connection has no minimum bitrate
+
+//--- AdaptiveBitrateController class ---//
+
+AdaptiveBitrateController::AdaptiveBitrateController()
+    : floorBitrate(0),
+      ceilingBitrate(0),
+      bitrate(0),
+      healthyTicks(0),
+      cooldownTicks(0),
+      primed(false),
+      lastTotalFrames(0),
+      lastDroppedFrames(0),
+      lastBytesSent(0),
+      lastTimestamp(0)
+{
+}
+
+void AdaptiveBitrateController::reset(int _floorBitrate, int _ceilingBitrate, int initialBitrate)
+{
+    ceilingBitrate = std::max(_ceilingBitrate, 1);
+    floorBitrate = _floorBitrate > 0 ? std::min(_floorBitrate, ceilingBitrate)
+                                     : std::max((int)(ceilingBitrate * ABR_FLOOR_RATIO), 1);
+    bitrate = std::clamp(initialBitrate, floorBitrate, ceilingBitrate);
+    healthyTicks = 0;
+    cooldownTicks = 0;
+    primed = false;
+}
+
+int AdaptiveBitrateController::update(
+    int totalFrames, int droppedFrames, uint64_t bytesSent, double congestion, uint64_t timestamp
+)
+{
+    if (!primed || totalFrames < lastTotalFrames || droppedFrames < lastDroppedFrames || bytesSent < lastBytesSent) {
+        // First sample or the output has been restarted -> Take baseline
+        primed = true;
+        lastTotalFrames = totalFrames;
+        lastDroppedFrames = droppedFrames;
+        lastBytesSent = bytesSent;
+        lastTimestamp = timestamp;
+        return bitrate;
+    }
+
+    auto frames = totalFrames - lastTotalFrames;
+    auto dropped = droppedFrames - lastDroppedFrames;
+    auto elapsed = timestamp - lastTimestamp;
+    // Throughput in kbps
+    auto throughput = elapsed > 0 ? (double)(bytesSent - lastBytesSent) * 8.0 * 1000000.0 / (double)elapsed : 0.0;
+
+    lastTotalFrames = totalFrames;
+    lastDroppedFrames = droppedFrames;
+    lastBytesSent = bytesSent;
+    lastTimestamp = timestamp;
+
+    if (frames <= 0) {
+        // Nothing has been sent during the tick
+        return bitrate;
+    }
+
+    auto dropRatio = (double)dropped / (double)frames;
+
+    if (dropRatio > ABR_DROP_RATIO_THRESHOLD || congestion > ABR_CONGESTION_THRESHOLD) {
+        healthyTicks = 0;
+        if (cooldownTicks > 0) {
+            cooldownTicks--;
+            return bitrate;
+        }
+
+        auto target = bitrate * ABR_DECREASE_FACTOR;
+        if (throughput > 0.0) {
+            target = std::min(target, throughput * ABR_THROUGHPUT_FACTOR);
+        }
+        bitrate = std::clamp((int)target, floorBitrate, ceilingBitrate);
+        cooldownTicks = ABR_COOLDOWN_TICKS;
+        return bitrate;
+    }
+
+    if (cooldownTicks > 0) {
+        cooldownTicks--;
+    }
+
+    if (dropped > 0 || congestion > ABR_CONGESTION_HEALTHY) {
+        // Marginal -> Hold current bitrate
+        healthyTicks = 0;
+        return bitrate;
+    }
+
+    if (++healthyTicks >= ABR_HEALTHY_TICKS && bitrate < ceilingBitrate) {
+        auto step = std::max((int)(ceilingBitrate * ABR_INCREASE_STEP_RATIO), 1);
+        bitrate = std::min(bitrate + step, ceilingBitrate);
+        healthyTicks = 0;
+    }
+
+    return bitrate;
+}
@@ -0,0 +1,48 @@
+/*
+SRC-Link
+Copyright (C) 2024 OPENSPHERE Inc. info@opensphere.co.jp
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+// Closed-loop bitrate controller (AIMD) fed by streaming output statistics.
+// Backs off multiplicatively on dropped frames or congestion, and recovers additively
+// after the link has been healthy for a while. The bitrate never leaves [floor, ceiling].
+class AdaptiveBitrateController {
+    int floorBitrate;   // kbps
+    int ceilingBitrate; // kbps
+    int bitrate;        // kbps
+    int healthyTicks;
+    int cooldownTicks;
+    bool primed;
+    int lastTotalFrames;
+    int lastDroppedFrames;
+    uint64_t lastBytesSent;
+    uint64_t lastTimestamp; // nanoseconds
+
+public:
+    explicit AdaptiveBitrateController();
+
+    void reset(int _floorBitrate, int _ceilingBitrate, int initialBitrate);
+    // Feeds cumulative output counters, returns the bitrate to be applied (kbps)
+    int update(int totalFrames, int droppedFrames, uint64_t bytesSent, double congestion, uint64_t timestamp);
+
+    inline int getBitrate() const { return bitrate; }
+    inline int getFloorBitrate() const { return floorBitrate; }
+    inline int getCeilingBitrate() const { return ceilingBitrate; }
+};
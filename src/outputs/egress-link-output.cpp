@@ -26,44 +26,25 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #include <QString>
 
 #include "egress-link-output.hpp"
-#include "audio-source.hpp"
+#include "encoder-pool.hpp"
 
 #define OUTPUT_MAX_RETRIES 0
 #define OUTPUT_RETRY_DELAY_SECS 1
 #define OUTPUT_JSON_NAME "output.json"
-#define OUTPUT_MONITORING_INTERVAL_MSECS 1000
+#define OUTPUT_WATCHDOG_INTERVAL_MSECS 5000
 #define OUTPUT_RETRY_TIMEOUT_MSECS 3500
 #define OUTPUT_START_DELAY_MSECS 1000
 #define OUTPUT_SCREENSHOT_HEIGHT 720
+#define OUTPUT_SCREENSHOT_KEEPALIVE_MSECS 60000
+#define OUTPUT_SCREENSHOT_HASH_THRESHOLD 3 // bits of 256
 #define OUTPUT_STATISTICS_INTERVAL_MSECS 5000
+#define OUTPUT_BITRATE_CONTROL_INTERVAL_MSECS 1000
 #define OUTPUT_ENCODER_PRESETS_DIR_NAME "presets"
 #define OUTPUT_DEFAULT_VIDEO_ENCODER "obs_x264"
 #define OUTPUT_DEFAULT_VIDEO_BITRATE 10000
 #define OUTPUT_DEFAULT_AUDIO_ENCODER "ffmpeg_aac"
 #define OUTPUT_DEFAULT_AUDIO_BITRATE 160
-
-inline audio_t *createSilenceAudio()
-{
-    obs_audio_info ai = {0};
-    if (!obs_get_audio_info(&ai)) {
-        return nullptr;
-    }
-
-    audio_output_info aoi = {0};
-    aoi.name = "Silence";
-    aoi.samples_per_sec = ai.samples_per_sec;
-    aoi.speakers = ai.speakers;
-    aoi.format = AUDIO_FORMAT_FLOAT_PLANAR;
-    aoi.input_param = nullptr;
-    aoi.input_callback = [](void *, uint64_t startTsIn, uint64_t, uint64_t *outTs, uint32_t, audio_output_data *) {
-        *outTs = startTsIn;
-        return true;
-    };
-
-    audio_t *audio = nullptr;
-    audio_output_open(&audio, &aoi);
-    return audio;
-}
+#define OUTPUT_WARMUP_OUTPUT_ID "null_output"
 
 // Imitate obs-studio/UI/window-basic-settings.cpp
 inline QString makeFormatToolTip()
@@ -118,42 +99,70 @@ EgressLinkOutput::EgressLinkOutput(const QString &_name, SRCLinkApiClient *_apiC
       apiClient(_apiClient),
       streamingOutput(nullptr),
       recordingOutput(nullptr),
+      warmupOutput(nullptr),
       service(nullptr),
       videoEncoder(nullptr),
       audioEncoder(nullptr),
-      audioSource(nullptr),
-      sourceView(nullptr),
       source(nullptr),
       settings(nullptr),
       storedSettingsRev(0),
       activeSettingsRev(0),
+      storedConnectionRev(0),
+      activeConnectionRev(0),
       status(EGRESS_LINK_OUTPUT_STATUS_INACTIVE),
       recordingStatus(RECORDING_OUTPUT_STATUS_INACTIVE),
+      connectionAttemptingAt(0),
+      pipelineCreatedAt(0),
+      connectionArrivedAt(0),
+      activationLatency(0),
       lastBytesSent(0),
       lastBytesSentTime(0),
       initialTotalFrames(0),
       initialDroppedFrames(0),
-      lastPutStatisticsAt(0)
+      initialSkippedFrames(0),
+      lastPutStatisticsAt(0),
+      lastScreenshotHash({{0}}),
+      lastScreenshotAt(0),
+      adaptiveBitrate(false)
 {
     obs_log(LOG_DEBUG, "%s: Output creating", qUtf8Printable(name));
 
     loadSettings();
+    prewarmStandBy = apiClient->getSettings()->getEgressPrewarmStandBy();
 
     snapshotTimer = new QTimer(this);
     snapshotTimer->setInterval(apiClient->getSettings()->getEgressScreenshotInterval() * 1000);
     snapshotTimer->start();
     connect(snapshotTimer, SIGNAL(timeout()), this, SLOT(onSnapshotTimerTimeout()));
 
-    monitoringTimer = new QTimer(this);
-    monitoringTimer->setInterval(OUTPUT_MONITORING_INTERVAL_MSECS);
-    monitoringTimer->start();
-    connect(monitoringTimer, SIGNAL(timeout()), this, SLOT(onMonitoringTimerTimeout()));
+    // The state machine is driven by output signals and frontend events, the watchdog is the fallback
+    watchdogTimer = new QTimer(this);
+    watchdogTimer->setInterval(OUTPUT_WATCHDOG_INTERVAL_MSECS);
+    watchdogTimer->start();
+    connect(watchdogTimer, SIGNAL(timeout()), this, SLOT(evaluate()));
+
+    evaluationTimer = new QTimer(this);
+    evaluationTimer->setSingleShot(true);
+    connect(evaluationTimer, SIGNAL(timeout()), this, SLOT(evaluate()));
+
+    statisticsTimer = new QTimer(this);
+    statisticsTimer->setInterval(OUTPUT_STATISTICS_INTERVAL_MSECS);
+    statisticsTimer->start();
+    connect(statisticsTimer, SIGNAL(timeout()), this, SLOT(onStatisticsTimerTimeout()));
+
+    bitrateTimer = new QTimer(this);
+    bitrateTimer->setInterval(OUTPUT_BITRATE_CONTROL_INTERVAL_MSECS);
+    bitrateTimer->start();
+    connect(bitrateTimer, SIGNAL(timeout()), this, SLOT(onBitrateTimerTimeout()));
 
     connect(apiClient, SIGNAL(uplinkReady(const UplinkInfo &)), this, SLOT(onUplinkReady(const UplinkInfo &)));
     connect(apiClient, &SRCLinkApiClient::egressRefreshNeeded, this, [this]() { refresh(); });
 
     obs_frontend_add_event_callback(onOBSFrontendEvent, this);
 
+    // Initial evaluation
+    scheduleEvaluation();
+
     obs_log(LOG_INFO, "%s: Output created", qUtf8Printable(name));
 }
 
@@ -179,6 +188,15 @@ void EgressLinkOutput::onOBSFrontendEvent(enum obs_frontend_event event, void *p
     case OBS_FRONTEND_EVENT_SCENE_COLLECTION_CHANGING:
         output->stop();
         break;
+    case OBS_FRONTEND_EVENT_STREAMING_STARTED:
+    case OBS_FRONTEND_EVENT_STREAMING_STOPPED:
+    case OBS_FRONTEND_EVENT_RECORDING_STARTED:
+    case OBS_FRONTEND_EVENT_RECORDING_STOPPED:
+    case OBS_FRONTEND_EVENT_VIRTUALCAM_STARTED:
+    case OBS_FRONTEND_EVENT_VIRTUALCAM_STOPPED:
+        // Interlock
+        output->scheduleEvaluation();
+        break;
     default:
         // Nothing to do
         break;
@@ -188,6 +206,18 @@ void EgressLinkOutput::onOBSFrontendEvent(enum obs_frontend_event event, void *p
 void EgressLinkOutput::refresh()
 {
     snapshotTimer->setInterval(apiClient->getSettings()->getEgressScreenshotInterval() * 1000);
+
+    auto prewarm = apiClient->getSettings()->getEgressPrewarmStandBy();
+    if (prewarm != prewarmStandBy) {
+        prewarmStandBy = prewarm;
+        if (status == EGRESS_LINK_OUTPUT_STATUS_STAND_BY) {
+            // Increment revision to rebuild stand-by pipeline
+            storedSettingsRev++;
+        }
+    }
+
+    // Interlock type may be changed
+    scheduleEvaluation();
 }
 
 obs_properties_t *EgressLinkOutput::getProperties()
@@ -265,6 +295,9 @@ obs_properties_t *EgressLinkOutput::getProperties()
         videoEncoderGroup, "video_encoder", obs_module_text("VideoEncoder"), OBS_COMBO_TYPE_LIST,
         OBS_COMBO_FORMAT_STRING
     );
+    auto adaptiveBitrateProp =
+        obs_properties_add_bool(videoEncoderGroup, "adaptive_bitrate", obs_module_text("AdaptiveBitrate"));
+    obs_property_set_long_description(adaptiveBitrateProp, obs_module_text("AdaptiveBitrate.Description"));
     obs_properties_add_group(
         props, "video_encoder_group", obs_module_text("VideoEncoder"), OBS_GROUP_NORMAL, videoEncoderGroup
     );
@@ -519,6 +552,7 @@ void EgressLinkOutput::getDefaults(obs_data_t *defaults)
 
     obs_data_set_default_string(defaults, "video_encoder", videoEncoderId);
     obs_data_set_default_int(defaults, "bitrate", videoBitrate);
+    obs_data_set_default_bool(defaults, "adaptive_bitrate", false);
     obs_data_set_default_string(defaults, "audio_encoder", audioEncoderId);
     obs_data_set_default_int(defaults, "audio_bitrate", audioBitrate);
     obs_data_set_default_string(defaults, "audio_source", "");
@@ -564,6 +598,7 @@ void EgressLinkOutput::update(obs_data_t *newSettings)
 
     // Increment revision to restart output
     storedSettingsRev++;
+    scheduleEvaluation();
 
     obs_log(LOG_INFO, "%s: Output updated", qUtf8Printable(name));
 }
@@ -581,6 +616,7 @@ void EgressLinkOutput::setSourceUuid(const QString &value)
 
     // Increment revision to restart output
     storedSettingsRev++;
+    scheduleEvaluation();
 }
 
 // Deprecated
@@ -826,7 +862,7 @@ obs_data_t *EgressLinkOutput::createRecordingSettings(obs_data_t *egressSettings
     return recordingSettings;
 }
 
-// Modifies state of members: connection
+// Modifies state of members: connection, lastConnection
 void EgressLinkOutput::retrieveConnection()
 {
     // Find connection specified by name
@@ -837,6 +873,10 @@ void EgressLinkOutput::retrieveConnection()
             break;
         }
     }
+
+    if (!connection.isEmpty()) {
+        lastConnection = connection;
+    }
 }
 
 // Add reference of source which specified by sourceUuid
@@ -853,82 +893,9 @@ bool EgressLinkOutput::createSource(QString sourceUuid)
     // DO NOT use obs_source_inc_active() because source's audio will be mixed in main output unexpectedly.
     obs_source_inc_showing(source);
 
-    return true;
-}
-
-// Modifies state of members: sourceView
-video_t *EgressLinkOutput::createVideo(obs_video_info *vi)
-{
-    auto video = obs_get_video();
-
-    if (source) {
-        // Video setup
-        obs_log(LOG_DEBUG, "%s: Video source is %s", qUtf8Printable(name), qUtf8Printable(obs_source_get_name(source)));
-
-        sourceView = obs_view_create();
-        obs_view_set_source(sourceView, 0, source);
-
-        // Force dot by dot at this stage
-        auto ovi = *vi;
-        ovi.output_width = ovi.base_width = obs_source_get_width(source);
-        ovi.output_height = ovi.base_height = obs_source_get_height(source);
-
-        if (ovi.base_width == 0 || ovi.base_height == 0 || ovi.output_width == 0 || ovi.output_height == 0) {
-            obs_log(LOG_ERROR, "%s: Invalid video spec", qUtf8Printable(name));
-            return nullptr;
-        }
-
-        video = obs_view_add2(sourceView, &ovi);
-        if (!video) {
-            obs_log(LOG_ERROR, "%s: Failed to create source video", qUtf8Printable(name));
-            return nullptr;
-        }
-    }
+    sourceRemoveSignal.Connect(obs_source_get_signal_handler(source), "remove", onSourceRemoved, this);
 
-    return video;
-}
-
-// Modifies state of members: audioSource, audioSilence
-audio_t *EgressLinkOutput::createAudio(QString audioSourceUuid)
-{
-    auto audio = obs_get_audio();
-
-    if (audioSourceUuid == "no_audio") {
-        // Silence
-        obs_log(LOG_DEBUG, "%s: Audio source: silence", qUtf8Printable(name));
-        audioSilence = createSilenceAudio();
-        if (!audioSilence) {
-            obs_log(LOG_ERROR, "%s: Failed to create silence audio", qUtf8Printable(name));
-            return nullptr;
-        }
-        audio = audioSilence;
-
-    } else if (audioSourceUuid != "program" && audioSourceUuid != "master_track") {
-        // Not master audio
-        OBSSourceAutoRelease customSource = obs_get_source_by_uuid(qUtf8Printable(audioSourceUuid));
-        if (customSource) {
-            obs_log(
-                LOG_DEBUG, "%s: Audio source: %s", qUtf8Printable(name),
-                qUtf8Printable(obs_source_get_name(customSource))
-            );
-            obs_audio_info ai = {0};
-            if (!obs_get_audio_info(&ai)) {
-                obs_log(LOG_ERROR, "%s: Failed to get audio info", qUtf8Printable(name));
-                return nullptr;
-            }
-
-            audioSource = new OutputAudioSource(customSource, ai.samples_per_sec, ai.speakers, this);
-            audio = audioSource->getAudio();
-            if (!audio) {
-                obs_log(LOG_ERROR, "%s: Failed to create audio source", qUtf8Printable(name));
-                delete audioSource;
-                audioSource = nullptr;
-                return nullptr;
-            }
-        }
-    }
-
-    return audio;
+    return true;
 }
 
 #define FTL_PROTOCOL "ftl"
@@ -968,6 +935,14 @@ bool EgressLinkOutput::createStreamingOutput(obs_data_t *egressSettings)
     obs_output_set_reconnect_settings(streamingOutput, OUTPUT_MAX_RETRIES, OUTPUT_RETRY_DELAY_SECS);
     obs_output_set_service(streamingOutput, service);
 
+    // Drive the state machine by output's signals
+    auto handler = obs_output_get_signal_handler(streamingOutput);
+    streamingStartSignal.Connect(handler, "start", onStreamingOutputStarted, this);
+    streamingActivateSignal.Connect(handler, "activate", onStreamingOutputActivated, this);
+    streamingStopSignal.Connect(handler, "stop", onOutputStopped, this);
+    streamingReconnectSignal.Connect(handler, "reconnect", onStreamingOutputReconnect, this);
+    streamingReconnectSuccessSignal.Connect(handler, "reconnect_success", onStreamingOutputReconnectSuccess, this);
+
     return true;
 }
 
@@ -990,74 +965,29 @@ bool EgressLinkOutput::createRecordingOutput(obs_data_t *egressSettings)
         return false;
     }
 
-    return true;
-}
-
-// Modifies state of members: videoEncoder, width, height
-bool EgressLinkOutput::createVideoEncoder(obs_data_t *egressSettings, video_t *video, int _width, int _height)
-{
-    auto videoEncoderId = obs_data_get_string(egressSettings, "video_encoder");
-    if (!videoEncoderId) {
-        obs_log(LOG_ERROR, "%s: Video encoder did't set", qUtf8Printable(name));
-        return false;
-    }
-    obs_log(LOG_DEBUG, "%s: Video encoder: %s", qUtf8Printable(name), videoEncoderId);
-    videoEncoder = obs_video_encoder_create(
-        videoEncoderId, qUtf8Printable(QString("%1.VideoEncoder").arg(name)), egressSettings, nullptr
-    );
-    if (!videoEncoder) {
-        obs_log(LOG_ERROR, "%s: Failed to create video encoder: %s", qUtf8Printable(name), videoEncoderId);
-        return false;
-    }
-
-    width = _width;
-    height = _height;
-
-    // Scale to connection's resolution
-    // TODO: Keep aspect ratio?
-    obs_encoder_set_scaled_size(videoEncoder, width, height);
-    obs_encoder_set_gpu_scale_type(videoEncoder, OBS_SCALE_LANCZOS);
-    obs_encoder_set_video(videoEncoder, video);
+    recordingStopSignal.Connect(obs_output_get_signal_handler(recordingOutput), "stop", onOutputStopped, this);
 
     return true;
 }
 
-// Modifies state of members: audioEncoder
-bool EgressLinkOutput::createAudioEncoder(obs_data_t *egressSettings, QString audioSourceUuid, audio_t *audio)
+// Modifies state of members: warmupOutput
+bool EgressLinkOutput::createWarmupOutput()
 {
-    auto audioEncoderId = obs_data_get_string(egressSettings, "audio_encoder");
-    if (!audioEncoderId) {
-        obs_log(LOG_ERROR, "%s: Audio encoder did't set", qUtf8Printable(name));
-        return false;
-    }
-    obs_log(LOG_DEBUG, "%s: Audio encoder: %s", qUtf8Printable(name), audioEncoderId);
-    auto audioBitrate = obs_data_get_int(egressSettings, "audio_bitrate");
-    OBSDataAutoRelease audioEncoderSettings = obs_encoder_defaults(audioEncoderId);
-    obs_data_set_int(audioEncoderSettings, "bitrate", audioBitrate);
-
-    // Determine audio track
-    size_t audioTrack = 0;
-    if (audioSourceUuid == "master_track") {
-        size_t value = obs_data_get_int(egressSettings, "audio_track");
-        audioTrack = value - 1;
-        obs_log(LOG_DEBUG, "%s: Audio source: Master track %d", qUtf8Printable(name), value);
-    }
-
-    audioEncoder = obs_audio_encoder_create(
-        audioEncoderId, qUtf8Printable(QString("%1.AudioEncoder").arg(name)), audioEncoderSettings, audioTrack, nullptr
-    );
-    if (!audioEncoder) {
-        obs_log(LOG_ERROR, "%s: Failed to create audio encoder: %s", qUtf8Printable(name), audioEncoderId);
+    // The output discards all packets, it only keeps the view and encoders running
+    warmupOutput =
+        obs_output_create(OUTPUT_WARMUP_OUTPUT_ID, qUtf8Printable(QString("%1.Warmup").arg(name)), nullptr, nullptr);
+    if (!warmupOutput) {
+        obs_log(LOG_WARNING, "%s: Failed to create warmup output", qUtf8Printable(name));
         return false;
     }
 
-    obs_encoder_set_audio(audioEncoder, audio);
-
     return true;
 }
 
 void EgressLinkOutput::start()
 {
+    bool startImmediately = false;
+
     QMutexLocker locker(&outputMutex);
     [&]() {
         //--- Determine source ---//
@@ -1077,8 +1007,12 @@ void EgressLinkOutput::start()
         // Connection available -> Go active state
         bool goActive = !connection.isEmpty() && status != EGRESS_LINK_OUTPUT_STATUS_ACTIVE;
         // Determine demand of pipline reconstruction
-        bool reconstructPipeline = sourceUuid != activeSourceUuid || goStandBy || goActive ||
-                                   activeSettingsRev != storedSettingsRev;
+        bool reconstructPipeline =
+            sourceUuid != activeSourceUuid || goStandBy || activeSettingsRev != storedSettingsRev;
+        // Connection changes only re-point the streaming output, encoders are kept if their inputs are unchanged
+        bool swapConnection = !reconstructPipeline && (goActive || activeConnectionRev != storedConnectionRev);
+        bool recordingRebuilt = false;
+        bool encodersKept = false;
 
         if (reconstructPipeline) {
             // Ensure resources are released
@@ -1094,6 +1028,13 @@ void EgressLinkOutput::start()
 
             activeSourceUuid = sourceUuid;
             activeSettingsRev = storedSettingsRev;
+            activeConnectionRev = storedConnectionRev;
+            pipelineCreatedAt = QDateTime().currentMSecsSinceEpoch();
+
+        } else if (swapConnection) {
+            obs_log(LOG_DEBUG, "%s: Swapping connection", qUtf8Printable(name));
+            destroyStreamingOutput();
+            activeConnectionRev = storedConnectionRev;
         }
 
         //--- Gather parameters ---//
@@ -1104,7 +1045,7 @@ void EgressLinkOutput::start()
             setStatus(EGRESS_LINK_OUTPUT_STATUS_STAND_BY);
         }
 
-        if (!streaming && !recording) {
+        if (!streaming && !recording && !prewarmStandBy) {
             // Both of output and recording are not enabled
             return;
         }
@@ -1133,7 +1074,16 @@ void EgressLinkOutput::start()
                 setStatus(EGRESS_LINK_OUTPUT_STATUS_ERROR);
                 return;
             }
-        } else {
+        } else if (!recording && !lastConnection.isEmpty()) {
+            // Pre-warming only
+            // Predict encoder parameters from the last connection, the encoders will be kept if it comes back
+            encoderWidth = lastConnection.getWidth();
+            encoderHeight = lastConnection.getHeight();
+
+            egressSettings = createEgressSettings(lastConnection);
+        }
+
+        if (!egressSettings) {
             // No uplink connections
             // Use output resolution
             encoderWidth = vi.output_width;
@@ -1144,19 +1094,59 @@ void EgressLinkOutput::start()
         }
 
         //--- Create encoders ---//
-        if (!videoEncoder) {
-            // Determine video source
-            auto video = createVideo(&vi);
-            if (!video) {
+        // The bitrate of the encoder is changed at runtime -> Do not share it with other outputs
+        auto videoEncoderId = obs_data_get_string(egressSettings, "video_encoder");
+        auto adaptive = obs_data_get_bool(settings, "adaptive_bitrate");
+        if (adaptive && !(obs_get_encoder_caps(videoEncoderId) & OBS_ENCODER_CAP_DYN_BITRATE)) {
+            obs_log(
+                LOG_WARNING, "%s: Encoder doesn't support dynamic bitrate: %s", qUtf8Printable(name), videoEncoderId
+            );
+            adaptive = false;
+        }
+
+        if (videoEncoder && swapConnection) {
+            // The pool returns the same encoder when resolution and settings are unchanged
+            auto nextVideoEncoder = EncoderPool::getInstance()->acquireVideoEncoder(
+                name, source, egressSettings, &vi, encoderWidth, encoderHeight, adaptive
+            );
+            if (!nextVideoEncoder) {
                 setStatus(EGRESS_LINK_OUTPUT_STATUS_ERROR);
                 return;
             }
 
-            // Create video encoder
-            if (!createVideoEncoder(egressSettings, video, encoderWidth, encoderHeight)) {
+            if (nextVideoEncoder == videoEncoder) {
+                // Drop extra reference
+                EncoderPool::getInstance()->releaseVideoEncoder(nextVideoEncoder);
+                obs_encoder_release(nextVideoEncoder);
+                encodersKept = true;
+            } else {
+                obs_log(LOG_DEBUG, "%s: Video encoder parameters changed", qUtf8Printable(name));
+                // The recording output must follow the new encoder
+                recordingRebuilt = recordingOutput != nullptr;
+                destroyRecordingOutput();
+                destroyWarmupOutput();
+
+                EncoderPool::getInstance()->releaseVideoEncoder(videoEncoder);
+                videoEncoder = nextVideoEncoder;
+                width = encoderWidth;
+                height = encoderHeight;
+                pipelineCreatedAt = QDateTime().currentMSecsSinceEpoch();
+            }
+        }
+
+        if (!videoEncoder) {
+            // Shared with other outputs which have identical source, resolution and settings
+            videoEncoder = EncoderPool::getInstance()->acquireVideoEncoder(
+                name, source, egressSettings, &vi, encoderWidth, encoderHeight, adaptive
+            );
+            if (!videoEncoder) {
                 setStatus(EGRESS_LINK_OUTPUT_STATUS_ERROR);
                 return;
             }
+
+            width = encoderWidth;
+            height = encoderHeight;
+            pipelineCreatedAt = QDateTime().currentMSecsSinceEpoch();
         }
 
         if (!audioEncoder) {
@@ -1167,17 +1157,19 @@ void EgressLinkOutput::start()
                 audioSourceUuid = activeSourceUuid;
             }
 
-            auto audio = createAudio(audioSourceUuid);
-            if (!audio) {
+            audioEncoder = EncoderPool::getInstance()->acquireAudioEncoder(
+                name, audioSourceUuid, egressSettings, apiClient->getSettings()->getEgressAudioTargetLatency()
+            );
+            if (!audioEncoder) {
                 setStatus(EGRESS_LINK_OUTPUT_STATUS_ERROR);
                 return;
             }
+        }
 
-            // Create audio encoder
-            if (!createAudioEncoder(egressSettings, audioSourceUuid, audio)) {
-                setStatus(EGRESS_LINK_OUTPUT_STATUS_ERROR);
-                return;
-            }
+        // Connection's bitrate window may be changed even if encoders are kept
+        adaptiveBitrate = adaptive && streaming;
+        if (adaptiveBitrate) {
+            resetBitrateController(egressSettings);
         }
 
         //--- Create outputs ---//
@@ -1196,27 +1188,45 @@ void EgressLinkOutput::start()
             }
         }
 
+        if (!warmupOutput && prewarmStandBy && !streaming) {
+            // Starts warming up later
+            createWarmupOutput();
+        }
+
         if (!streamingOutput && !recordingOutput) {
             // Both of output and recording are not ready
             return;
         }
 
         //--- Start recording output ---//
-        if (reconstructPipeline && recordingOutput) {
+        if ((reconstructPipeline || recordingRebuilt) && recordingOutput) {
             // Starts recording output later
             setRecordingStatus(RECORDING_OUTPUT_STATUS_ACTIVATING);
         }
 
         //--- Start streaming output ---//
-        if (reconstructPipeline && streamingOutput) {
+        if ((reconstructPipeline || swapConnection) && streamingOutput) {
             // Save current timestamp to reduce reconnection with timeout
-            connectionAttemptingAt = QDateTime().currentMSecsSinceEpoch();
+            // Encoders are already warm on swapping -> No need to wait OUTPUT_START_DELAY_MSECS
+            connectionAttemptingAt =
+                QDateTime().currentMSecsSinceEpoch() - (encodersKept ? OUTPUT_START_DELAY_MSECS : 0);
             // Starts streaming output later
             setStatus(EGRESS_LINK_OUTPUT_STATUS_ACTIVATING);
+            // Encoders are running already -> Only the network output has to start
+            startImmediately = encodersKept && obs_encoder_active(videoEncoder);
         }
     }();
     apiClient->syncUplinkStatus();
     locker.unlock();
+
+    if (startImmediately) {
+        startStreaming();
+    } else if (status == EGRESS_LINK_OUTPUT_STATUS_ACTIVATING ||
+               recordingStatus == RECORDING_OUTPUT_STATUS_ACTIVATING ||
+               (warmupOutput && !obs_output_active(warmupOutput))) {
+        // Activate outputs after delay
+        scheduleEvaluation();
+    }
 }
 
 void EgressLinkOutput::startStreaming()
@@ -1230,6 +1240,8 @@ void EgressLinkOutput::startStreaming()
             obs_output_set_video_encoder(streamingOutput, videoEncoder);
             obs_output_set_audio_encoder(streamingOutput, audioEncoder, 0); // Don't support multiple audio outputs
 
+            auto warm = obs_encoder_active(videoEncoder);
+
             if (!obs_output_start(streamingOutput)) {
                 obs_log(LOG_ERROR, "%s: Failed to start streaming output", qUtf8Printable(name));
                 setStatus(EGRESS_LINK_OUTPUT_STATUS_ERROR);
@@ -1237,7 +1249,10 @@ void EgressLinkOutput::startStreaming()
                 if (source) {
                     obs_source_inc_showing(source);
                 }
-                obs_log(LOG_INFO, "%s: Activated streaming output", qUtf8Printable(name));
+                obs_log(
+                    LOG_INFO, "%s: Activated streaming output (encoders=%s)", qUtf8Printable(name),
+                    warm ? "warm" : "cold"
+                );
                 setStatus(EGRESS_LINK_OUTPUT_STATUS_ACTIVE);
             }
         }
@@ -1270,10 +1285,41 @@ void EgressLinkOutput::startRecording()
 }
 
 // Modifies state of members:
-//   source, activeSourceUuid, streamingOutput, recordingOutput, service, videoEncoder, audioEncoder, sourceView,
-//   audioSource, audioSilence
+//   source, activeSourceUuid, streamingOutput, recordingOutput, service, videoEncoder, audioEncoder
 void EgressLinkOutput::destroyPipeline(EgressLinkOutputStatus nextStatus, RecordingOutputStatus nextRecordingStatus)
 {
+    destroyRecordingOutput();
+    destroyStreamingOutput();
+    destroyWarmupOutput();
+    adaptiveBitrate = false;
+
+    // The pool destroys encoders, views and audio pipelines when no other output shares them
+    if (audioEncoder) {
+        EncoderPool::getInstance()->releaseAudioEncoder(audioEncoder);
+    }
+    audioEncoder = nullptr;
+
+    if (videoEncoder) {
+        EncoderPool::getInstance()->releaseVideoEncoder(videoEncoder);
+    }
+    videoEncoder = nullptr;
+
+    sourceRemoveSignal.Disconnect();
+    if (source) {
+        obs_source_dec_showing(source);
+    }
+    source = nullptr;
+    activeSourceUuid = QString();
+
+    setStatus(nextStatus);
+    setRecordingStatus(nextRecordingStatus);
+}
+
+// Modifies state of members: recordingOutput
+void EgressLinkOutput::destroyRecordingOutput()
+{
+    recordingStopSignal.Disconnect();
+
     if (recordingOutput) {
         if (recordingStatus == RECORDING_OUTPUT_STATUS_ACTIVE) {
             if (source) {
@@ -1283,6 +1329,16 @@ void EgressLinkOutput::destroyPipeline(EgressLinkOutputStatus nextStatus, Record
         }
     }
     recordingOutput = nullptr;
+}
+
+// Modifies state of members: streamingOutput, service
+void EgressLinkOutput::destroyStreamingOutput()
+{
+    streamingStartSignal.Disconnect();
+    streamingActivateSignal.Disconnect();
+    streamingStopSignal.Disconnect();
+    streamingReconnectSignal.Disconnect();
+    streamingReconnectSuccessSignal.Disconnect();
 
     if (streamingOutput) {
         if (status == EGRESS_LINK_OUTPUT_STATUS_ACTIVE || status == EGRESS_LINK_OUTPUT_STATUS_RECONNECTING) {
@@ -1293,31 +1349,16 @@ void EgressLinkOutput::destroyPipeline(EgressLinkOutputStatus nextStatus, Record
         }
     }
     streamingOutput = nullptr;
-
     service = nullptr;
-    audioEncoder = nullptr;
-    videoEncoder = nullptr;
-
-    if (sourceView) {
-        obs_view_set_source(sourceView, 0, nullptr);
-        obs_view_remove(sourceView);
-    }
-    sourceView = nullptr;
-
-    if (source) {
-        obs_source_dec_showing(source);
-    }
-    source = nullptr;
-    activeSourceUuid = QString();
+}
 
-    if (audioSource) {
-        delete audioSource;
-        audioSource = nullptr;
+// Modifies state of members: warmupOutput
+void EgressLinkOutput::destroyWarmupOutput()
+{
+    if (warmupOutput && obs_output_active(warmupOutput)) {
+        obs_output_stop(warmupOutput);
     }
-    audioSilence = nullptr;
-
-    setStatus(nextStatus);
-    setRecordingStatus(nextRecordingStatus);
+    warmupOutput = nullptr;
 }
 
 void EgressLinkOutput::stop()
@@ -1327,6 +1368,8 @@ void EgressLinkOutput::stop()
         auto stopStatus = status != EGRESS_LINK_OUTPUT_STATUS_INACTIVE;
 
         destroyPipeline();
+        // Do not measure activation latency across stopping
+        connectionArrivedAt = 0;
 
         if (stopStatus) {
             obs_log(LOG_INFO, "%s: Inactivated output", qUtf8Printable(name));
@@ -1336,6 +1379,29 @@ void EgressLinkOutput::stop()
     locker.unlock();
 }
 
+void EgressLinkOutput::startWarmup()
+{
+    QMutexLocker locker(&outputMutex);
+    {
+        if (warmupOutput && streamingOutput) {
+            // Too late, the streaming output starts encoders by itself
+            destroyWarmupOutput();
+        } else if (warmupOutput) {
+            obs_output_set_video_encoder(warmupOutput, videoEncoder);
+            obs_output_set_audio_encoder(warmupOutput, audioEncoder, 0);
+
+            if (!obs_output_start(warmupOutput)) {
+                obs_log(LOG_WARNING, "%s: Failed to start warmup output", qUtf8Printable(name));
+                // Do not retry
+                warmupOutput = nullptr;
+            } else {
+                obs_log(LOG_DEBUG, "%s: Encoders have been warmed up", qUtf8Printable(name));
+            }
+        }
+    }
+    locker.unlock();
+}
+
 void EgressLinkOutput::restartStreaming()
 {
     QMutexLocker locker(&outputMutex);
@@ -1375,20 +1441,57 @@ void EgressLinkOutput::onSnapshotTimerTimeout()
 
     // Upload screenshot during output is active
     OBSSourceAutoRelease ssSource = obs_frontend_get_current_scene();
-    bool success = false;
+    QImage screenshot;
     // Keep source's aspect ratio
-    auto screenshot = source ? takeSourceScreenshot(source, success, 0, OUTPUT_SCREENSHOT_HEIGHT)
-                             : takeSourceScreenshot(ssSource, success, 0, OUTPUT_SCREENSHOT_HEIGHT);
+    // GPU resources are kept by the engine, the image is read back from the last capture
+    auto success = screenshotEngine.capture(source ? source : ssSource, screenshot, 0, OUTPUT_SCREENSHOT_HEIGHT);
 
-    if (success) {
-        apiClient->putScreenshot(name, screenshot);
+    if (!success) {
+        return;
+    }
+
+    // Skip upload if the frame hasn't changed meaningfully, but keep alive at longer interval
+    auto hash = computeDifferenceHash(
+        screenshot.constBits(), screenshot.width(), screenshot.height(), screenshot.bytesPerLine()
+    );
+    auto now = QDateTime().currentMSecsSinceEpoch();
+    if (lastScreenshotAt && now - lastScreenshotAt < OUTPUT_SCREENSHOT_KEEPALIVE_MSECS &&
+        hammingDistance(hash, lastScreenshotHash) <= OUTPUT_SCREENSHOT_HASH_THRESHOLD) {
+        return;
+    }
+
+    // Record the hash only when accepted, otherwise the dropped frame would be regarded as uploaded
+    if (apiClient->putScreenshot(name, screenshot)) {
+        lastScreenshotHash = hash;
+        lastScreenshotAt = now;
     }
 }
 
-// Called every OUTPUT_MONITORING_INTERVAL_MSECS
-void EgressLinkOutput::onMonitoringTimerTimeout()
+// Called every OUTPUT_STATISTICS_INTERVAL_MSECS
+void EgressLinkOutput::onStatisticsTimerTimeout()
+{
+    if ((status == EGRESS_LINK_OUTPUT_STATUS_ACTIVE || status == EGRESS_LINK_OUTPUT_STATUS_RECONNECTING) &&
+        QDateTime().currentMSecsSinceEpoch() - lastPutStatisticsAt >= OUTPUT_STATISTICS_INTERVAL_MSECS / 2) {
+        // Skip if statistics have been put by status change recently
+        updateStatistics();
+    }
+}
+
+// Coalesces evaluation requests, the earliest schedule wins
+void EgressLinkOutput::scheduleEvaluation(int delayMsecs)
+{
+    if (evaluationTimer->isActive() && evaluationTimer->remainingTime() <= delayMsecs) {
+        return;
+    }
+    evaluationTimer->start(delayMsecs);
+}
+
+// The state machine of the output.
+// Called on output signals, frontend events, settings/connection changes and every OUTPUT_WATCHDOG_INTERVAL_MSECS
+void EgressLinkOutput::evaluate()
 {
     auto interlockType = apiClient->getSettings()->value("interlock_type", DEFAULT_INTERLOCK_TYPE);
+    qint64 now = QDateTime().currentMSecsSinceEpoch();
 
     auto activateStreaming = status == EGRESS_LINK_OUTPUT_STATUS_ACTIVATING;
     auto activateRecording = recordingStatus == RECORDING_OUTPUT_STATUS_ACTIVATING;
@@ -1396,9 +1499,13 @@ void EgressLinkOutput::onMonitoringTimerTimeout()
                                    status != EGRESS_LINK_OUTPUT_STATUS_STAND_BY &&
                                    status != EGRESS_LINK_OUTPUT_STATUS_RECONNECTING;
 
-    if ((status == EGRESS_LINK_OUTPUT_STATUS_ACTIVE || status == EGRESS_LINK_OUTPUT_STATUS_RECONNECTING) &&
-        QDateTime().currentMSecsSinceEpoch() - lastPutStatisticsAt > OUTPUT_STATISTICS_INTERVAL_MSECS) {
-        updateStatistics();
+    if (warmupOutput && !obs_output_active(warmupOutput)) {
+        if (now - (qint64)pipelineCreatedAt > OUTPUT_START_DELAY_MSECS) {
+            // Delaying at least OUTPUT_START_DELAY_MSECS after creating pipeline
+            startWarmup();
+        } else {
+            scheduleEvaluation((int)(pipelineCreatedAt + OUTPUT_START_DELAY_MSECS + 1 - now));
+        }
     }
 
     if (status == EGRESS_LINK_OUTPUT_STATUS_CHANGING) {
@@ -1408,7 +1515,7 @@ void EgressLinkOutput::onMonitoringTimerTimeout()
     } else if (activateStreaming || activateRecording) {
         // Prioritize activating output
 
-        if (QDateTime().currentMSecsSinceEpoch() - connectionAttemptingAt > OUTPUT_START_DELAY_MSECS) {
+        if (now - (qint64)connectionAttemptingAt > OUTPUT_START_DELAY_MSECS) {
             // Delaying at least OUTPUT_START_DELAY_MSECS after attempting activate
             if (activateStreaming) {
                 startStreaming();
@@ -1416,6 +1523,8 @@ void EgressLinkOutput::onMonitoringTimerTimeout()
             if (activateRecording) {
                 startRecording();
             }
+        } else {
+            scheduleEvaluation((int)(connectionAttemptingAt + OUTPUT_START_DELAY_MSECS + 1 - now));
         }
 
     } else if (streamingInactiveStatus) {
@@ -1439,7 +1548,7 @@ void EgressLinkOutput::onMonitoringTimerTimeout()
             }
         }
 
-    } else if (QDateTime().currentMSecsSinceEpoch() - connectionAttemptingAt > OUTPUT_RETRY_TIMEOUT_MSECS) {
+    } else if (now - (qint64)connectionAttemptingAt > OUTPUT_RETRY_TIMEOUT_MSECS) {
         // Delaying at least OUTPUT_RETRY_TIMEOUT_MSECS after attempting start
         if (interlockType.isEmpty()) {
             // Always off
@@ -1474,10 +1583,12 @@ void EgressLinkOutput::onMonitoringTimerTimeout()
             return;
         }
 
-        if (activeSettingsRev < storedSettingsRev && !obs_output_reconnecting(streamingOutput)) {
+        if ((activeSettingsRev < storedSettingsRev || activeConnectionRev < storedConnectionRev) &&
+            !obs_output_reconnecting(streamingOutput)) {
             obs_log(LOG_DEBUG, "%s: Attempting change settings", qUtf8Printable(name));
             // Do it next turn to avoid crashing
             setStatus(EGRESS_LINK_OUTPUT_STATUS_CHANGING);
+            scheduleEvaluation();
             return;
         }
 
@@ -1493,6 +1604,7 @@ void EgressLinkOutput::onMonitoringTimerTimeout()
             // Reconnect
             obs_log(LOG_DEBUG, "%s: Attempting restart output", qUtf8Printable(name));
             restartStreaming();
+            scheduleEvaluation(OUTPUT_RETRY_TIMEOUT_MSECS + 1);
             return;
         }
 
@@ -1506,9 +1618,63 @@ void EgressLinkOutput::onMonitoringTimerTimeout()
             stop();
             return;
         }
+
+    } else {
+        // Re-check when OUTPUT_RETRY_TIMEOUT_MSECS elapsed
+        scheduleEvaluation((int)(connectionAttemptingAt + OUTPUT_RETRY_TIMEOUT_MSECS + 1 - now));
     }
 }
 
+// Called every OUTPUT_BITRATE_CONTROL_INTERVAL_MSECS
+void EgressLinkOutput::onBitrateTimerTimeout()
+{
+    if (!adaptiveBitrate || status != EGRESS_LINK_OUTPUT_STATUS_ACTIVE || !streamingOutput || !videoEncoder) {
+        return;
+    }
+
+    auto totalFrames = obs_output_get_total_frames(streamingOutput);
+    auto droppedFrames = obs_output_get_frames_dropped(streamingOutput);
+    auto congestion = obs_output_get_congestion(streamingOutput);
+    auto prevBitrate = bitrateController.getBitrate();
+    auto nextBitrate = bitrateController.update(
+        totalFrames, droppedFrames, obs_output_get_total_bytes(streamingOutput), congestion, os_gettime_ns()
+    );
+
+    if (nextBitrate != prevBitrate) {
+        obs_log(
+            LOG_INFO, "%s: Adaptive bitrate %d -> %d kbps (frames=%d, dropped=%d, congestion=%.2f)",
+            qUtf8Printable(name), prevBitrate, nextBitrate, totalFrames, droppedFrames, congestion
+        );
+        setVideoBitrate(nextBitrate);
+    }
+}
+
+// Modifies state of members: bitrateController
+void EgressLinkOutput::resetBitrateController(obs_data_t *egressSettings)
+{
+    // Upper limit is the user's bitrate which has been clamped to connection's window
+    auto ceilingBitrate = (int)obs_data_get_int(egressSettings, "bitrate");
+    OBSDataAutoRelease encoderSettings = obs_encoder_get_settings(videoEncoder);
+    auto currentBitrate = (int)obs_data_get_int(encoderSettings, "bitrate");
+
+    bitrateController.reset(connection.getMinBitrate(), ceilingBitrate, currentBitrate);
+    obs_log(
+        LOG_DEBUG, "%s: Adaptive bitrate enabled: %d - %d kbps", qUtf8Printable(name),
+        bitrateController.getFloorBitrate(), bitrateController.getCeilingBitrate()
+    );
+
+    if (bitrateController.getBitrate() != currentBitrate) {
+        setVideoBitrate(bitrateController.getBitrate());
+    }
+}
+
+void EgressLinkOutput::setVideoBitrate(int bitrate)
+{
+    OBSDataAutoRelease encoderSettings = obs_encoder_get_settings(videoEncoder);
+    obs_data_set_int(encoderSettings, "bitrate", bitrate);
+    obs_encoder_update(videoEncoder, encoderSettings);
+}
+
 void EgressLinkOutput::setStatus(EgressLinkOutputStatus value)
 {
     if (status != value) {
@@ -1533,7 +1699,7 @@ void EgressLinkOutput::setStatus(EgressLinkOutputStatus value)
         }
 
         status = value;
-        updateStatistics();
+        updateStatistics(true);
         emit statusChanged(status);
     }
 }
@@ -1542,7 +1708,7 @@ void EgressLinkOutput::setRecordingStatus(RecordingOutputStatus value)
 {
     if (recordingStatus != value) {
         recordingStatus = value;
-        updateStatistics();
+        updateStatistics(true);
         emit recordingStatusChanged(recordingStatus);
     }
 }
@@ -1556,6 +1722,7 @@ void EgressLinkOutput::setVisible(bool value)
 
     // Increment revision to restart output
     storedSettingsRev++;
+    scheduleEvaluation();
 }
 
 void EgressLinkOutput::onUplinkReady(const UplinkInfo &uplink)
@@ -1569,12 +1736,103 @@ void EgressLinkOutput::onUplinkReady(const UplinkInfo &uplink)
         obs_log(LOG_DEBUG, "%s: The connection has been changed", qUtf8Printable(name));
         // The connection will be retrieved in start() again.
         connection = incomingConnection;
-        // Increment revision to restart output
-        storedSettingsRev++;
+        // Increment revision to re-point streaming output (Encoders are kept)
+        storedConnectionRev++;
+
+        if (!incomingConnection.isEmpty()) {
+            connectionArrivedAt = os_gettime_ns();
+        }
+        scheduleEvaluation();
+    }
+}
+
+// Output's signal handlers are called from OBS's threads -> Forward to the thread of the output.
+
+void EgressLinkOutput::onStreamingOutputStarted(void *data, calldata_t *)
+{
+    auto output = static_cast<EgressLinkOutput *>(data);
+
+    // Only the first start after a connection arrival is counted (Ignore reconnections)
+    auto arrivedAt = output->connectionArrivedAt.exchange(0);
+    if (arrivedAt) {
+        output->activationLatency = os_gettime_ns() - arrivedAt;
+        obs_log(
+            LOG_INFO, "%s: Activation latency %.1f ms", qUtf8Printable(output->name), output->getActivationLatency()
+        );
     }
+
+    QMetaObject::invokeMethod(
+        output,
+        [output]() {
+            if (output->status == EGRESS_LINK_OUTPUT_STATUS_RECONNECTING) {
+                // Reconnected
+                output->setStatus(EGRESS_LINK_OUTPUT_STATUS_ACTIVE);
+            }
+        },
+        Qt::QueuedConnection
+    );
 }
 
-void EgressLinkOutput::updateStatistics()
+void EgressLinkOutput::onStreamingOutputActivated(void *data, calldata_t *)
+{
+    auto output = static_cast<EgressLinkOutput *>(data);
+    QMetaObject::invokeMethod(
+        output,
+        [output]() {
+            QMutexLocker locker(&output->outputMutex);
+            if (output->warmupOutput) {
+                // The streaming output keeps encoders running from now on
+                output->destroyWarmupOutput();
+                obs_log(LOG_DEBUG, "%s: Released warmup output", qUtf8Printable(output->name));
+            }
+            locker.unlock();
+        },
+        Qt::QueuedConnection
+    );
+}
+
+void EgressLinkOutput::onStreamingOutputReconnect(void *data, calldata_t *)
+{
+    auto output = static_cast<EgressLinkOutput *>(data);
+    QMetaObject::invokeMethod(
+        output,
+        [output]() {
+            if (output->status == EGRESS_LINK_OUTPUT_STATUS_ACTIVE) {
+                output->setStatus(EGRESS_LINK_OUTPUT_STATUS_RECONNECTING);
+            }
+        },
+        Qt::QueuedConnection
+    );
+}
+
+void EgressLinkOutput::onStreamingOutputReconnectSuccess(void *data, calldata_t *)
+{
+    auto output = static_cast<EgressLinkOutput *>(data);
+    QMetaObject::invokeMethod(
+        output,
+        [output]() {
+            if (output->status == EGRESS_LINK_OUTPUT_STATUS_RECONNECTING) {
+                output->setStatus(EGRESS_LINK_OUTPUT_STATUS_ACTIVE);
+            }
+        },
+        Qt::QueuedConnection
+    );
+}
+
+// Streaming or recording output stopped (Includes unexpected disconnection)
+void EgressLinkOutput::onOutputStopped(void *data, calldata_t *)
+{
+    auto output = static_cast<EgressLinkOutput *>(data);
+    QMetaObject::invokeMethod(output, [output]() { output->scheduleEvaluation(); }, Qt::QueuedConnection);
+}
+
+void EgressLinkOutput::onSourceRemoved(void *data, calldata_t *)
+{
+    auto output = static_cast<EgressLinkOutput *>(data);
+    QMetaObject::invokeMethod(output, [output]() { output->scheduleEvaluation(); }, Qt::QueuedConnection);
+}
+
+void EgressLinkOutput::updateStatistics(bool immediate)
 {
     uint64_t totalBytes = streamingOutput ? obs_output_get_total_bytes(streamingOutput) : 0;
     uint64_t curTime = os_gettime_ns();
@@ -1610,6 +1868,25 @@ void EgressLinkOutput::updateStatistics()
     lastBytesSent = bytesSent;
     lastBytesSentTime = curTime;
 
+    // Frames skipped by encoding lag, counted from output started
+    auto video = videoEncoder ? obs_encoder_video(videoEncoder) : obs_get_video();
+    uint32_t skippedFrames = video ? video_output_get_skipped_frames(video) : 0;
+    if (!streamingOutput || skippedFrames < initialSkippedFrames) {
+        initialSkippedFrames = skippedFrames;
+    }
+    skippedFrames -= initialSkippedFrames;
+
+    // Configured keyframe interval in frames (0 means auto)
+    int keyframeInterval = 0;
+    if (videoEncoder) {
+        OBSDataAutoRelease encoderSettings = obs_encoder_get_settings(videoEncoder);
+        auto keyintSec = obs_data_get_int(encoderSettings, "keyint_sec");
+        auto videoInfo = video ? video_output_get_info(video) : nullptr;
+        if (keyintSec > 0 && videoInfo && videoInfo->fps_den > 0) {
+            keyframeInterval = (int)(keyintSec * videoInfo->fps_num / videoInfo->fps_den);
+        }
+    }
+
     auto outputStatus = status == EGRESS_LINK_OUTPUT_STATUS_ACTIVE         ? OUTPUT_STATUS_ACTIVE
                         : status == EGRESS_LINK_OUTPUT_STATUS_ACTIVATING   ? OUTPUT_STATUS_STAND_BY
                         : status == EGRESS_LINK_OUTPUT_STATUS_RECONNECTING ? OUTPUT_STATUS_RECONNECTING
@@ -1623,10 +1900,15 @@ void EgressLinkOutput::updateStatistics()
     metric.setTotalFrames(totalFrames);
     metric.setDroppedFrames(droppedFrames);
     metric.setTotalSize((qint64)totalBytes);
+    metric.setCongestion(streamingOutput ? obs_output_get_congestion(streamingOutput) : 0.0);
+    metric.setConnectTime(streamingOutput ? obs_output_get_connect_time_ms(streamingOutput) : 0);
+    metric.setActivationLatency(getActivationLatency());
+    metric.setSkippedFrames((int)skippedFrames);
+    metric.setConfiguredKeyframeInterval(keyframeInterval);
 
     lastPutStatisticsAt = QDateTime().currentMSecsSinceEpoch();
 
-    apiClient->putStatistics(name, outputStatus, recording, metric);
+    apiClient->putStatistics(name, outputStatus, recording, metric, immediate);
 
-    emit statisticsUpdated((double)bitrate, totalFrames, droppedFrames, totalBytes);
+    emit statisticsUpdated(metric);
 }
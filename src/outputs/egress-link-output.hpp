@@ -26,17 +26,20 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #include <QObject>
 #include <QMutex>
 
+#include <atomic>
+
 #include "../api-client.hpp"
 #include "../schema.hpp"
 #include "../utils.hpp"
+#include "bitrate-controller.hpp"
+#include "screenshot-engine.hpp"
+#include "image-hash.hpp"
 
 #define DEFAULT_INTERLOCK_TYPE "virtual_cam"
 
 #define PROGRAM_OUT_SOURCE QString()
 #define INTERLOCK_TYPE_NONE QString()
 
-class OutputAudioSource;
-
 enum EgressLinkOutputStatus {
     EGRESS_LINK_OUTPUT_STATUS_INACTIVE,
     EGRESS_LINK_OUTPUT_STATUS_STAND_BY,
@@ -63,33 +66,54 @@ class EgressLinkOutput : public QObject {
 
     SRCLinkApiClient *apiClient;
     StageConnection connection;
+    StageConnection lastConnection; // Used to predict encoder parameters while standing by
     OBSDataAutoRelease settings;
     OBSServiceAutoRelease service;
     OBSOutputAutoRelease streamingOutput;
     OBSOutputAutoRelease recordingOutput;
+    OBSOutputAutoRelease warmupOutput; // Keeps encoders running while standing by
     OBSEncoderAutoRelease videoEncoder;
     OBSEncoderAutoRelease audioEncoder;
     OBSSourceAutoRelease source; // NULL if main output is used.
-    OBSView sourceView;
-    OBSAudio audioSilence;
-    OutputAudioSource *audioSource;
     QMutex outputMutex;
+    OBSSignal streamingStartSignal;
+    OBSSignal streamingActivateSignal;
+    OBSSignal streamingStopSignal;
+    OBSSignal streamingReconnectSignal;
+    OBSSignal streamingReconnectSuccessSignal;
+    OBSSignal recordingStopSignal;
+    OBSSignal sourceRemoveSignal;
 
     EgressLinkOutputStatus status;
     RecordingOutputStatus recordingStatus;
     QString activeSourceUuid;
     int storedSettingsRev;
     int activeSettingsRev;
+    int storedConnectionRev;
+    int activeConnectionRev;
     uint64_t connectionAttemptingAt; // milliseconds
+    uint64_t pipelineCreatedAt;      // milliseconds
+    bool prewarmStandBy;
+    std::atomic<uint64_t> connectionArrivedAt; // nanoseconds
+    std::atomic<uint64_t> activationLatency;   // nanoseconds
     QTimer *snapshotTimer;
-    QTimer *monitoringTimer;
+    QTimer *watchdogTimer;
+    QTimer *evaluationTimer;
+    QTimer *statisticsTimer;
+    QTimer *bitrateTimer;
     int width;
     int height;
     uint64_t lastBytesSent;
     uint64_t lastBytesSentTime;
     int initialTotalFrames;
     int initialDroppedFrames;
+    uint32_t initialSkippedFrames;
     uint64_t lastPutStatisticsAt; // milliseconds
+    ImageHash lastScreenshotHash;
+    uint64_t lastScreenshotAt; // milliseconds
+    bool adaptiveBitrate;
+    AdaptiveBitrateController bitrateController;
+    ScreenshotEngine screenshotEngine;
 
     void loadProfile(obs_data_t *settings);
     void loadPreset(obs_data_t *settings, const QString &encoderId);
@@ -105,28 +129,40 @@ class EgressLinkOutput : public QObject {
     void restartRecording();
     void retrieveConnection();
     bool createSource(QString sourceUuid);
-    video_t *createVideo(obs_video_info *vi);
-    audio_t *createAudio(QString audioSourceUuid);
     bool createStreamingOutput(obs_data_t *egressSettings);
     bool createRecordingOutput(obs_data_t *egressSettings);
-    bool createVideoEncoder(obs_data_t *egressSettings, video_t *video, int width, int height);
-    bool createAudioEncoder(obs_data_t *egressSettings, QString audioSourceUuid, audio_t *audio);
+    bool createWarmupOutput();
+    void startWarmup();
+    void destroyStreamingOutput();
+    void destroyRecordingOutput();
+    void destroyWarmupOutput();
     void destroyPipeline(
         EgressLinkOutputStatus nextStatus = EGRESS_LINK_OUTPUT_STATUS_INACTIVE,
         RecordingOutputStatus nextRecordingStatus = RECORDING_OUTPUT_STATUS_INACTIVE
     );
-    void updateStatistics();
+    void updateStatistics(bool immediate = false);
+    void scheduleEvaluation(int delayMsecs = 0);
+    void resetBitrateController(obs_data_t *egressSettings);
+    void setVideoBitrate(int bitrate);
 
     static void onOBSFrontendEvent(enum obs_frontend_event event, void *paramd);
+    static void onStreamingOutputStarted(void *data, calldata_t *cd);
+    static void onStreamingOutputActivated(void *data, calldata_t *cd);
+    static void onStreamingOutputReconnect(void *data, calldata_t *cd);
+    static void onStreamingOutputReconnectSuccess(void *data, calldata_t *cd);
+    static void onOutputStopped(void *data, calldata_t *cd);
+    static void onSourceRemoved(void *data, calldata_t *cd);
 
 signals:
     void statusChanged(EgressLinkOutputStatus status);
     void recordingStatusChanged(RecordingOutputStatus status);
-    void statisticsUpdated(double bitrate, int totalFrames, int droppedFrames, uint64_t bytesSent);
+    void statisticsUpdated(const OutputMetric &metric);
 
 private slots:
     void onSnapshotTimerTimeout();
-    void onMonitoringTimerTimeout();
+    void onStatisticsTimerTimeout();
+    void evaluate();
+    void onBitrateTimerTimeout();
     void onUplinkReady(const UplinkInfo &uplink);
 
 public:
@@ -149,4 +185,6 @@ public:
     inline EgressLinkOutputStatus getStatus() const { return status; }
     inline RecordingOutputStatus getRecordingStatus() const { return recordingStatus; }
     inline bool getVisible() const { return obs_data_get_bool(settings, "visible"); }
+    // Time from connection arrival to the streaming output started (milliseconds)
+    inline double getActivationLatency() const { return activationLatency / 1000000.0; }
 };
@@ -0,0 +1,382 @@
+/*
+SRC-Link
+Copyright (C) 2024 OPENSPHERE Inc. info@opensphere.co.jp
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <obs-module.h>
+
+#include <QCryptographicHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include "../plugin-support.h"
+#include "encoder-pool.hpp"
+#include "audio-source.hpp"
+
+inline audio_t *createSilenceAudio()
+{
+    obs_audio_info ai = {0};
+    if (!obs_get_audio_info(&ai)) {
+        return nullptr;
+    }
+
+    audio_output_info aoi = {0};
+    aoi.name = "Silence";
+    aoi.samples_per_sec = ai.samples_per_sec;
+    aoi.speakers = ai.speakers;
+    aoi.format = AUDIO_FORMAT_FLOAT_PLANAR;
+    aoi.input_param = nullptr;
+    aoi.input_callback = [](void *, uint64_t startTsIn, uint64_t, uint64_t *outTs, uint32_t, audio_output_data *) {
+        *outTs = startTsIn;
+        return true;
+    };
+
+    audio_t *audio = nullptr;
+    audio_output_open(&audio, &aoi);
+    return audio;
+}
+
+// Digest of the settings which the encoder actually consumes (Ignores server, key, recording, etc.)
+inline QString encoderSettingsDigest(const char *encoderId, obs_data_t *settings)
+{
+    OBSDataAutoRelease defaults = obs_encoder_defaults(encoderId);
+    auto values = QJsonDocument::fromJson(obs_data_get_json(settings)).object();
+
+    QJsonObject filtered;
+    for (auto item = obs_data_first(defaults); item; obs_data_item_next(&item)) {
+        QString itemName = obs_data_item_get_name(item);
+        if (values.contains(itemName)) {
+            filtered[itemName] = values[itemName];
+        }
+    }
+
+    return QCryptographicHash::hash(QJsonDocument(filtered).toJson(QJsonDocument::Compact), QCryptographicHash::Sha1)
+        .toHex();
+}
+
+//--- EncoderPool class ---//
+
+EncoderPool *EncoderPool::instance = nullptr;
+
+EncoderPool::EncoderPool(QObject *parent) : QObject(parent) {}
+
+EncoderPool::~EncoderPool()
+{
+    // Remaining entries must not exist at this point, release them anyway.
+    foreach (auto entry, videoEntries) {
+        destroyVideoEntry(entry);
+    }
+    videoEntries.clear();
+
+    foreach (auto entry, audioEntries) {
+        destroyAudioEntry(entry);
+    }
+    audioEntries.clear();
+}
+
+EncoderPool *EncoderPool::getInstance()
+{
+    if (!instance) {
+        instance = new EncoderPool();
+    }
+    return instance;
+}
+
+void EncoderPool::destroyInstance()
+{
+    if (instance) {
+        delete instance;
+        instance = nullptr;
+    }
+}
+
+// Modifies state of entry: view
+video_t *EncoderPool::createVideo(VideoEntry *entry, const QString &name, obs_source_t *source, obs_video_info *vi)
+{
+    auto video = obs_get_video();
+
+    if (source) {
+        // Video setup
+        obs_log(LOG_DEBUG, "%s: Video source is %s", qUtf8Printable(name), qUtf8Printable(obs_source_get_name(source)));
+
+        entry->view = obs_view_create();
+        obs_view_set_source(entry->view, 0, source);
+
+        // Force dot by dot at this stage
+        auto ovi = *vi;
+        ovi.output_width = ovi.base_width = obs_source_get_width(source);
+        ovi.output_height = ovi.base_height = obs_source_get_height(source);
+
+        if (ovi.base_width == 0 || ovi.base_height == 0 || ovi.output_width == 0 || ovi.output_height == 0) {
+            obs_log(LOG_ERROR, "%s: Invalid video spec", qUtf8Printable(name));
+            return nullptr;
+        }
+
+        video = obs_view_add2(entry->view, &ovi);
+        if (!video) {
+            obs_log(LOG_ERROR, "%s: Failed to create source video", qUtf8Printable(name));
+            return nullptr;
+        }
+    }
+
+    return video;
+}
+
+// Modifies state of entry: audioSource, silence
+audio_t *EncoderPool::createAudio(
+    AudioEntry *entry, const QString &name, const QString &audioSourceUuid, int targetLatencyMsecs
+)
+{
+    auto audio = obs_get_audio();
+
+    if (audioSourceUuid == "no_audio") {
+        // Silence
+        obs_log(LOG_DEBUG, "%s: Audio source: silence", qUtf8Printable(name));
+        entry->silence = createSilenceAudio();
+        if (!entry->silence) {
+            obs_log(LOG_ERROR, "%s: Failed to create silence audio", qUtf8Printable(name));
+            return nullptr;
+        }
+        audio = entry->silence;
+
+    } else if (audioSourceUuid != "program" && audioSourceUuid != "master_track") {
+        // Not master audio
+        OBSSourceAutoRelease customSource = obs_get_source_by_uuid(qUtf8Printable(audioSourceUuid));
+        if (customSource) {
+            obs_log(
+                LOG_DEBUG, "%s: Audio source: %s", qUtf8Printable(name),
+                qUtf8Printable(obs_source_get_name(customSource))
+            );
+            obs_audio_info ai = {0};
+            if (!obs_get_audio_info(&ai)) {
+                obs_log(LOG_ERROR, "%s: Failed to get audio info", qUtf8Printable(name));
+                return nullptr;
+            }
+
+            entry->audioSource =
+                new OutputAudioSource(customSource, ai.samples_per_sec, ai.speakers, targetLatencyMsecs);
+            audio = entry->audioSource->getAudio();
+            if (!audio) {
+                obs_log(LOG_ERROR, "%s: Failed to create audio source", qUtf8Printable(name));
+                return nullptr;
+            }
+        }
+    }
+
+    return audio;
+}
+
+void EncoderPool::destroyVideoEntry(VideoEntry *entry)
+{
+    entry->encoder = nullptr;
+
+    if (entry->view) {
+        obs_view_set_source(entry->view, 0, nullptr);
+        obs_view_remove(entry->view);
+    }
+    entry->view = nullptr;
+
+    delete entry;
+}
+
+void EncoderPool::destroyAudioEntry(AudioEntry *entry)
+{
+    entry->encoder = nullptr;
+
+    if (entry->audioSource) {
+        delete entry->audioSource;
+        entry->audioSource = nullptr;
+    }
+    entry->silence = nullptr;
+
+    delete entry;
+}
+
+obs_encoder_t *EncoderPool::acquireVideoEncoder(
+    const QString &name, obs_source_t *source, obs_data_t *egressSettings, obs_video_info *vi, int width, int height,
+    bool exclusive
+)
+{
+    auto videoEncoderId = obs_data_get_string(egressSettings, "video_encoder");
+    if (!videoEncoderId || !strlen(videoEncoderId)) {
+        obs_log(LOG_ERROR, "%s: Video encoder did't set", qUtf8Printable(name));
+        return nullptr;
+    }
+
+    auto key = QString("%1|%2x%3|%4|%5")
+                   .arg(source ? obs_source_get_uuid(source) : "program")
+                   .arg(width)
+                   .arg(height)
+                   .arg(videoEncoderId)
+                   .arg(encoderSettingsDigest(videoEncoderId, egressSettings));
+    if (exclusive) {
+        // Only the same output can get it again
+        key += QString("|exclusive:%1").arg(name);
+    }
+
+    QMutexLocker locker(&poolMutex);
+
+    auto entry = videoEntries.value(key);
+    if (entry) {
+        entry->refs++;
+        obs_log(
+            LOG_DEBUG, "%s: Share video encoder %s (refs=%d)", qUtf8Printable(name),
+            obs_encoder_get_name(entry->encoder), entry->refs
+        );
+        return obs_encoder_get_ref(entry->encoder);
+    }
+
+    entry = new VideoEntry{key, nullptr, nullptr, 1};
+
+    // Determine video source
+    auto video = createVideo(entry, name, source, vi);
+    if (!video) {
+        destroyVideoEntry(entry);
+        return nullptr;
+    }
+
+    obs_log(LOG_DEBUG, "%s: Video encoder: %s", qUtf8Printable(name), videoEncoderId);
+    entry->encoder = obs_video_encoder_create(
+        videoEncoderId, qUtf8Printable(QString("%1.VideoEncoder").arg(name)), egressSettings, nullptr
+    );
+    if (!entry->encoder) {
+        obs_log(LOG_ERROR, "%s: Failed to create video encoder: %s", qUtf8Printable(name), videoEncoderId);
+        destroyVideoEntry(entry);
+        return nullptr;
+    }
+
+    // Scale to connection's resolution
+    // TODO: Keep aspect ratio?
+    obs_encoder_set_scaled_size(entry->encoder, width, height);
+    obs_encoder_set_gpu_scale_type(entry->encoder, OBS_SCALE_LANCZOS);
+    obs_encoder_set_video(entry->encoder, video);
+
+    videoEntries.insert(key, entry);
+
+    return obs_encoder_get_ref(entry->encoder);
+}
+
+obs_encoder_t *EncoderPool::acquireAudioEncoder(
+    const QString &name, const QString &audioSourceUuid, obs_data_t *egressSettings, int targetLatencyMsecs
+)
+{
+    auto audioEncoderId = obs_data_get_string(egressSettings, "audio_encoder");
+    if (!audioEncoderId || !strlen(audioEncoderId)) {
+        obs_log(LOG_ERROR, "%s: Audio encoder did't set", qUtf8Printable(name));
+        return nullptr;
+    }
+    auto audioBitrate = obs_data_get_int(egressSettings, "audio_bitrate");
+
+    // Determine audio track
+    size_t audioTrack = 0;
+    if (audioSourceUuid == "master_track") {
+        size_t value = obs_data_get_int(egressSettings, "audio_track");
+        audioTrack = value - 1;
+    }
+
+    auto key = QString("%1|%2|%3|%4").arg(audioSourceUuid).arg(audioTrack).arg(audioEncoderId).arg(audioBitrate);
+
+    QMutexLocker locker(&poolMutex);
+
+    auto entry = audioEntries.value(key);
+    if (entry) {
+        entry->refs++;
+        obs_log(
+            LOG_DEBUG, "%s: Share audio encoder %s (refs=%d)", qUtf8Printable(name),
+            obs_encoder_get_name(entry->encoder), entry->refs
+        );
+        return obs_encoder_get_ref(entry->encoder);
+    }
+
+    entry = new AudioEntry{key, nullptr, nullptr, nullptr, 1};
+
+    auto audio = createAudio(entry, name, audioSourceUuid, targetLatencyMsecs);
+    if (!audio) {
+        destroyAudioEntry(entry);
+        return nullptr;
+    }
+
+    obs_log(LOG_DEBUG, "%s: Audio encoder: %s", qUtf8Printable(name), audioEncoderId);
+    OBSDataAutoRelease audioEncoderSettings = obs_encoder_defaults(audioEncoderId);
+    obs_data_set_int(audioEncoderSettings, "bitrate", audioBitrate);
+
+    if (audioSourceUuid == "master_track") {
+        obs_log(LOG_DEBUG, "%s: Audio source: Master track %d", qUtf8Printable(name), audioTrack + 1);
+    }
+
+    entry->encoder = obs_audio_encoder_create(
+        audioEncoderId, qUtf8Printable(QString("%1.AudioEncoder").arg(name)), audioEncoderSettings, audioTrack, nullptr
+    );
+    if (!entry->encoder) {
+        obs_log(LOG_ERROR, "%s: Failed to create audio encoder: %s", qUtf8Printable(name), audioEncoderId);
+        destroyAudioEntry(entry);
+        return nullptr;
+    }
+
+    obs_encoder_set_audio(entry->encoder, audio);
+
+    audioEntries.insert(key, entry);
+
+    return obs_encoder_get_ref(entry->encoder);
+}
+
+void EncoderPool::releaseVideoEncoder(obs_encoder_t *encoder)
+{
+    QMutexLocker locker(&poolMutex);
+
+    for (auto it = videoEntries.begin(); it != videoEntries.end(); it++) {
+        auto entry = it.value();
+        if (entry->encoder != encoder) {
+            continue;
+        }
+        if (--entry->refs <= 0) {
+            obs_log(LOG_DEBUG, "Video encoder %s released", obs_encoder_get_name(encoder));
+            videoEntries.erase(it);
+            destroyVideoEntry(entry);
+        }
+        return;
+    }
+}
+
+void EncoderPool::releaseAudioEncoder(obs_encoder_t *encoder)
+{
+    QMutexLocker locker(&poolMutex);
+
+    for (auto it = audioEntries.begin(); it != audioEntries.end(); it++) {
+        auto entry = it.value();
+        if (entry->encoder != encoder) {
+            continue;
+        }
+        if (--entry->refs <= 0) {
+            obs_log(LOG_DEBUG, "Audio encoder %s released", obs_encoder_get_name(encoder));
+            audioEntries.erase(it);
+            destroyAudioEntry(entry);
+        }
+        return;
+    }
+}
+
+int EncoderPool::getVideoEncoderRefs(obs_encoder_t *encoder)
+{
+    QMutexLocker locker(&poolMutex);
+
+    foreach (auto entry, videoEntries) {
+        if (entry->encoder == encoder) {
+            return entry->refs;
+        }
+    }
+    return 0;
+}
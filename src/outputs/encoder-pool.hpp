@@ -0,0 +1,85 @@
+/*
+SRC-Link
+Copyright (C) 2024 OPENSPHERE Inc. info@opensphere.co.jp
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <obs-module.h>
+#include <obs.hpp>
+
+#include <QObject>
+#include <QMap>
+#include <QMutex>
+
+#include "../utils.hpp"
+
+class OutputAudioSource;
+
+// Shares video/audio encoders (and the view/audio pipelines feeding them) across EgressLinkOutputs
+// whose source, resolution and encoder settings are identical.
+class EncoderPool : public QObject {
+    Q_OBJECT
+
+    struct VideoEntry {
+        QString key;
+        OBSView view; // NULL if main output is used.
+        OBSEncoderAutoRelease encoder;
+        int refs;
+    };
+
+    struct AudioEntry {
+        QString key;
+        OBSAudio silence;
+        OutputAudioSource *audioSource;
+        OBSEncoderAutoRelease encoder;
+        int refs;
+    };
+
+    // Singleton instance
+    static EncoderPool *instance;
+
+    QMap<QString, VideoEntry *> videoEntries;
+    QMap<QString, AudioEntry *> audioEntries;
+    QMutex poolMutex;
+
+    video_t *createVideo(VideoEntry *entry, const QString &name, obs_source_t *source, obs_video_info *vi);
+    audio_t *
+    createAudio(AudioEntry *entry, const QString &name, const QString &audioSourceUuid, int targetLatencyMsecs);
+    void destroyVideoEntry(VideoEntry *entry);
+    void destroyAudioEntry(AudioEntry *entry);
+
+protected:
+    explicit EncoderPool(QObject *parent = nullptr);
+    ~EncoderPool();
+
+public:
+    static EncoderPool *getInstance();
+    static void destroyInstance();
+
+    // Returned encoder is a new strong reference, must be paired with release*Encoder()
+    // Exclusive encoder is never shared with other outputs (e.g. its bitrate is changed at runtime)
+    obs_encoder_t *acquireVideoEncoder(
+        const QString &name, obs_source_t *source, obs_data_t *egressSettings, obs_video_info *vi, int width,
+        int height, bool exclusive = false
+    );
+    obs_encoder_t *acquireAudioEncoder(
+        const QString &name, const QString &audioSourceUuid, obs_data_t *egressSettings, int targetLatencyMsecs
+    );
+    void releaseVideoEncoder(obs_encoder_t *encoder);
+    void releaseAudioEncoder(obs_encoder_t *encoder);
+    int getVideoEncoderRefs(obs_encoder_t *encoder);
+};
@@ -0,0 +1,85 @@
+/*
+SRC-Link
+Copyright (C) 2024 OPENSPHERE Inc. info@opensphere.co.jp
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <bitset>
+
+#include "image-hash.hpp"
+
+#define IMAGE_HASH_COLS 17
+#define IMAGE_HASH_ROWS 16
+#define IMAGE_HASH_ROW_STEP 2 // Sampling every other row is enough for block averages
+
+ImageHash computeDifferenceHash(const uint8_t *rgba, uint32_t width, uint32_t height, size_t stride)
+{
+    ImageHash hash = {{0}};
+    if (width < IMAGE_HASH_COLS || height < IMAGE_HASH_ROWS) {
+        return hash;
+    }
+
+    uint32_t colBounds[IMAGE_HASH_COLS + 1];
+    for (uint32_t gx = 0; gx <= IMAGE_HASH_COLS; gx++) {
+        colBounds[gx] = gx * width / IMAGE_HASH_COLS;
+    }
+
+    uint64_t blocks[IMAGE_HASH_ROWS][IMAGE_HASH_COLS] = {{0}};
+    uint32_t blockRows[IMAGE_HASH_ROWS] = {0};
+
+    for (uint32_t gy = 0; gy < IMAGE_HASH_ROWS; gy++) {
+        const auto y0 = gy * height / IMAGE_HASH_ROWS;
+        const auto y1 = (gy + 1) * height / IMAGE_HASH_ROWS;
+
+        for (auto y = y0; y < y1; y += IMAGE_HASH_ROW_STEP) {
+            const auto line = rgba + y * stride;
+            for (uint32_t gx = 0; gx < IMAGE_HASH_COLS; gx++) {
+                // Contiguous and branchless -> Vectorized by compiler
+                uint32_t sum = 0;
+                for (auto x = colBounds[gx]; x < colBounds[gx + 1]; x++) {
+                    const auto pixel = line + x * 4;
+                    // Approximate luma: (R + 2G + B)
+                    sum += pixel[0] + (pixel[1] << 1) + pixel[2];
+                }
+                blocks[gy][gx] += sum;
+            }
+            blockRows[gy]++;
+        }
+    }
+
+    // Compare average of adjacent blocks
+    int bit = 0;
+    for (uint32_t gy = 0; gy < IMAGE_HASH_ROWS; gy++) {
+        for (uint32_t gx = 0; gx < IMAGE_HASH_COLS - 1; gx++, bit++) {
+            // Multiply by the width of other block instead of dividing
+            const auto left = blocks[gy][gx] * (colBounds[gx + 2] - colBounds[gx + 1]);
+            const auto right = blocks[gy][gx + 1] * (colBounds[gx + 1] - colBounds[gx]);
+            if (left < right) {
+                hash.bits[bit / 64] |= 1ULL << (bit % 64);
+            }
+        }
+    }
+
+    return hash;
+}
+
+int hammingDistance(const ImageHash &a, const ImageHash &b)
+{
+    int distance = 0;
+    for (int i = 0; i < IMAGE_HASH_WORDS; i++) {
+        distance += (int)std::bitset<64>(a.bits[i] ^ b.bits[i]).count();
+    }
+    return distance;
+}
@@ -0,0 +1,34 @@
+/*
+SRC-Link
+Copyright (C) 2024 OPENSPHERE Inc. info@opensphere.co.jp
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define IMAGE_HASH_WORDS 4 // 256 bits
+
+struct ImageHash {
+    uint64_t bits[IMAGE_HASH_WORDS];
+};
+
+// Difference hash of an RGBA8888 image.
+// The image is reduced to 17x16 luma blocks and each bit represents the gradient of adjacent blocks,
+// so that noise and compression artifacts don't affect but content changes do.
+ImageHash computeDifferenceHash(const uint8_t *rgba, uint32_t width, uint32_t height, size_t stride);
+int hammingDistance(const ImageHash &a, const ImageHash &b);
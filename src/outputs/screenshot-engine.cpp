@@ -0,0 +1,176 @@
+/*
+SRC-Link
+Copyright (C) 2024 OPENSPHERE Inc. info@opensphere.co.jp
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <obs-module.h>
+
+#include "../plugin-support.h"
+#include "screenshot-engine.hpp"
+
+//--- ScreenshotEngine class ---//
+
+ScreenshotEngine::ScreenshotEngine()
+    : texRender(nullptr),
+      stageSurfaces{nullptr},
+      width(0),
+      height(0),
+      stagedIndex(-1),
+      stagedSource(nullptr)
+{
+}
+
+ScreenshotEngine::~ScreenshotEngine()
+{
+    if (!texRender) {
+        // Never captured
+        return;
+    }
+
+    obs_enter_graphics();
+    resetSurfaces(0, 0);
+    gs_texrender_destroy(texRender);
+    texRender = nullptr;
+    obs_leave_graphics();
+}
+
+// Modifies state of members: stageSurfaces, width, height, stagedIndex
+void ScreenshotEngine::resetSurfaces(uint32_t _width, uint32_t _height)
+{
+    for (auto &stageSurface : stageSurfaces) {
+        gs_stagesurface_destroy(stageSurface);
+        stageSurface = nullptr;
+    }
+
+    width = _width;
+    height = _height;
+    stagedIndex = -1;
+    stagedSource = nullptr;
+
+    if (!width || !height) {
+        return;
+    }
+
+    for (auto &stageSurface : stageSurfaces) {
+        stageSurface = gs_stagesurface_create(width, height, GS_RGBA);
+    }
+}
+
+bool ScreenshotEngine::readStagedSurface(QImage &image)
+{
+    uint8_t *videoData = nullptr;
+    uint32_t videoLinesize = 0;
+
+    if (!gs_stagesurface_map(stageSurfaces[stagedIndex], &videoData, &videoLinesize)) {
+        return false;
+    }
+
+    image = QImage(width, height, QImage::Format::Format_RGBA8888);
+    auto lineSize = image.bytesPerLine();
+    for (uint32_t y = 0; y < height; y++) {
+        memcpy(image.scanLine(y), videoData + (y * videoLinesize), lineSize);
+    }
+    gs_stagesurface_unmap(stageSurfaces[stagedIndex]);
+
+    return true;
+}
+
+bool ScreenshotEngine::capture(obs_source_t *source, QImage &image, uint32_t requestedWidth, uint32_t requestedHeight)
+{
+    // Get info about the requested source
+    const uint32_t sourceWidth = obs_source_get_width(source);
+    const uint32_t sourceHeight = obs_source_get_height(source);
+    if (!sourceWidth || !sourceHeight) {
+        return false;
+    }
+    const double sourceAspectRatio = ((double)sourceWidth / (double)sourceHeight);
+
+    uint32_t imgWidth = sourceWidth;
+    uint32_t imgHeight = sourceHeight;
+
+    // Determine suitable image width
+    if (requestedWidth) {
+        imgWidth = requestedWidth;
+
+        if (!requestedHeight)
+            imgHeight = (uint32_t)((double)imgWidth / sourceAspectRatio);
+    }
+
+    // Determine suitable image height
+    if (requestedHeight) {
+        imgHeight = requestedHeight;
+
+        if (!requestedWidth)
+            imgWidth = (uint32_t)((double)imgHeight * sourceAspectRatio);
+    }
+
+    bool success = false;
+
+    // Enter graphics context
+    obs_enter_graphics();
+
+    if (!texRender) {
+        texRender = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+    }
+    if (imgWidth != width || imgHeight != height) {
+        // Resolution changed -> Staged frame is discarded
+        resetSurfaces(imgWidth, imgHeight);
+    }
+    if (source != stagedSource) {
+        // Do not show the frame of other source
+        stagedIndex = -1;
+    }
+
+    // Read back the frame staged by the last capture, the copy has been completed since long ago.
+    auto primed = stagedIndex >= 0;
+    if (primed) {
+        success = readStagedSurface(image);
+    }
+
+    // Render and stage current frame for the next capture
+    gs_texrender_reset(texRender);
+    if (gs_texrender_begin(texRender, imgWidth, imgHeight)) {
+        vec4 background;
+        vec4_zero(&background);
+
+        gs_clear(GS_CLEAR_COLOR, &background, 0.0f, 0);
+        gs_ortho(0.0f, (float)sourceWidth, 0.0f, (float)sourceHeight, -100.0f, 100.0f);
+
+        gs_blend_state_push();
+        gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+
+        obs_source_inc_showing(source);
+        obs_source_video_render(source);
+        obs_source_dec_showing(source);
+
+        gs_blend_state_pop();
+        gs_texrender_end(texRender);
+
+        // Use the other surface than the one just read
+        stagedIndex = (stagedIndex + 1) % SCREENSHOT_STAGE_SURFACES;
+        stagedSource = source;
+        gs_stage_texture(stageSurfaces[stagedIndex], gs_texrender_get_texture(texRender));
+
+        if (!primed) {
+            // The very first capture has no previous frame -> Read back synchronously only once
+            success = readStagedSurface(image);
+        }
+    }
+
+    obs_leave_graphics();
+
+    return success;
+}
@@ -0,0 +1,48 @@
+/*
+SRC-Link
+Copyright (C) 2024 OPENSPHERE Inc. info@opensphere.co.jp
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <obs-module.h>
+
+#include <QImage>
+
+#define SCREENSHOT_STAGE_SURFACES 2
+
+// Per-output screenshot engine which keeps GPU resources alive across captures.
+// The frame rendered by a capture is staged and read back by the next capture, so that
+// mapping never waits for the GPU to finish the copy (The image is one interval old).
+class ScreenshotEngine {
+    gs_texrender_t *texRender;
+    gs_stagesurf_t *stageSurfaces[SCREENSHOT_STAGE_SURFACES];
+    uint32_t width;
+    uint32_t height;
+    int stagedIndex;                  // -1 if nothing staged
+    const obs_source_t *stagedSource; // Only for identification, never dereferenced
+
+    // Must be called in graphics context
+    void resetSurfaces(uint32_t _width, uint32_t _height);
+    bool readStagedSurface(QImage &image);
+
+public:
+    explicit ScreenshotEngine();
+    ~ScreenshotEngine();
+
+    // Returns false if no image is available yet
+    bool capture(obs_source_t *source, QImage &image, uint32_t requestedWidth = 0, uint32_t requestedHeight = 0);
+};
@@ -33,6 +33,7 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #include "UI/egress-link-dock.hpp"
 #include "UI/ws-portal-dock.hpp"
 #include "ws-portal/event-handler.hpp"
+#include "outputs/encoder-pool.hpp"
 
 OBS_DECLARE_MODULE()
 OBS_MODULE_USE_DEFAULT_LOCALE(PLUGIN_NAME, "en-US")
@@ -166,6 +167,8 @@ void obs_module_unload(void)
     apiClient = nullptr;
 
     WsPortalEventHandler::destroyInstance();
+    // Outputs have been deleted with apiClient
+    EncoderPool::destroyInstance();
 
     // Destroy the cpu stats
     os_cpu_usage_info_destroy(cpuUsageInfo);
@@ -0,0 +1,55 @@
+/*
+SRC-Link
+Copyright (C) 2024 OPENSPHERE Inc. info@opensphere.co.jp
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <QRandomGenerator>
+
+#include <algorithm>
+
+#define RECONNECT_BACKOFF_BASE_MSECS 500
+#define RECONNECT_BACKOFF_MAX_MSECS 30000
+
+// Capped exponential backoff with jitter for reconnection.
+// The jitter spreads reconnects of many instances after a server outage.
+class ReconnectBackoff {
+    int baseMsecs;
+    int maxMsecs;
+    int attempts;
+
+public:
+    explicit ReconnectBackoff(
+        int _baseMsecs = RECONNECT_BACKOFF_BASE_MSECS, int _maxMsecs = RECONNECT_BACKOFF_MAX_MSECS
+    )
+        : baseMsecs(_baseMsecs),
+          maxMsecs(_maxMsecs),
+          attempts(0)
+    {
+    }
+
+    // Returns the delay of next attempt: Random between half and full of the capped exponential value
+    inline int next()
+    {
+        auto ceiling = attempts < 16 ? std::min(maxMsecs, baseMsecs << attempts) : maxMsecs;
+        attempts++;
+        return ceiling / 2 + (int)QRandomGenerator::global()->bounded(ceiling / 2 + 1);
+    }
+
+    inline void reset() { attempts = 0; }
+    inline int getAttempts() const { return attempts; }
+};
@@ -18,6 +18,8 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 
 #include <obs-module.h>
 
+#include <QSet>
+
 #include "request-invoker.hpp"
 #include "plugin-support.h"
 
@@ -31,33 +33,210 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 
 //--- RequestSequencer class ---//
 
-RequestSequencer::RequestSequencer(QNetworkAccessManager *_networkManager, O2 *_client, QObject *parent)
+RequestSequencer::RequestSequencer(
+    QNetworkAccessManager *_networkManager, O2 *_client, QObject *parent, int _maxConcurrentRequests
+)
     : QObject(parent),
       networkManager(_networkManager),
-      client(_client)
+      client(_client),
+      maxConcurrentRequests(_maxConcurrentRequests),
+      refreshing(false)
 {
+    connect(
+        client, SIGNAL(refreshFinished(QNetworkReply::NetworkError)), this,
+        SLOT(onO2RefreshFinished(QNetworkReply::NetworkError))
+    );
+
     TRACE("RequestSequencer created");
 }
 
 RequestSequencer::~RequestSequencer()
 {
-    if (!requestQueue.isEmpty()) {
-        obs_log(LOG_WARNING, "Remaining %d requests in queue.", requestQueue.size());
+    if (!pendingQueue.isEmpty() || !runningRequests.isEmpty() || !replayQueue.isEmpty()) {
+        obs_log(
+            LOG_WARNING, "Remaining %d requests in queue, %d running and %d waiting for refresh.", pendingQueue.size(),
+            runningRequests.size(), replayQueue.size()
+        );
     }
 
     TRACE("RequestSequencer destroyed");
 }
 
+void RequestSequencer::enqueue(RequestInvoker *invoker, const std::function<void()> &invoke)
+{
+    QMutexLocker locker(&mutex);
+    {
+        pendingQueue.append({invoker, invoke});
+        TRACE("Queue request: pending=%d, running=%d", pendingQueue.size(), runningRequests.size());
+    }
+    locker.unlock();
+
+    dispatch();
+}
+
+void RequestSequencer::release(RequestInvoker *invoker)
+{
+    QMutexLocker locker(&mutex);
+    {
+        runningRequests.removeOne(invoker);
+    }
+    locker.unlock();
+
+    dispatch();
+}
+
+// Hold the request rejected with 401 until the token is refreshed, only the first one starts refresh
+void RequestSequencer::replayAfterRefresh(RequestInvoker *invoker, const std::function<void()> &invoke)
+{
+    auto startRefresh = false;
+
+    QMutexLocker locker(&mutex);
+    {
+        runningRequests.removeOne(invoker);
+        replayQueue.append({invoker, invoke});
+        startRefresh = !refreshing;
+        refreshing = true;
+        TRACE("Request rejected: waiting=%d, refreshing=%d", replayQueue.size(), !startRefresh);
+    }
+    locker.unlock();
+
+    if (startRefresh) {
+        obs_log(LOG_INFO, "Access token rejected, refreshing");
+        client->refresh();
+    }
+}
+
+void RequestSequencer::onO2RefreshFinished(QNetworkReply::NetworkError error)
+{
+    QList<PendingRequest> rejected;
+
+    QMutexLocker locker(&mutex);
+    {
+        if (!refreshing) {
+            // Refreshed by exclusive request
+            return;
+        }
+        refreshing = false;
+        rejected = replayQueue;
+        replayQueue.clear();
+
+        if (error == QNetworkReply::NoError) {
+            // Replay ahead of requests held meanwhile, keeping the order for the same resource
+            pendingQueue = rejected + pendingQueue;
+            rejected.clear();
+        }
+        TRACE("Refresh finished: error=%d, pending=%d", error, pendingQueue.size());
+    }
+    locker.unlock();
+
+    for (const auto &request : rejected) {
+        emit request.invoker->finished(QNetworkReply::AuthenticationRequiredError, QByteArray());
+        request.invoker->deleteLater();
+    }
+
+    dispatch();
+}
+
+bool RequestSequencer::isLastPending(RequestInvoker *invoker)
+{
+    auto found = false;
+    for (const auto &pending : pendingQueue) {
+        if (pending.invoker == invoker) {
+            found = true;
+        } else if (found && (pending.invoker->exclusive || pending.invoker->resourceKey == invoker->resourceKey)) {
+            // Superseding would change order
+            return false;
+        }
+    }
+    return found;
+}
+
+// Start pending requests as much as possible
+void RequestSequencer::dispatch()
+{
+    QList<std::function<void()>> ready;
+
+    QMutexLocker locker(&mutex);
+    {
+        if (refreshing) {
+            // Requests sent now would be rejected with the stale token
+            return;
+        }
+
+        QSet<QString> busyKeys;
+        for (auto running : runningRequests) {
+            if (running->exclusive) {
+                // Block everything until the exclusive one finished
+                return;
+            }
+            if (!running->resourceKey.isEmpty()) {
+                busyKeys.insert(running->resourceKey);
+            }
+        }
+
+        for (auto it = pendingQueue.begin();
+             it != pendingQueue.end() && runningRequests.size() < maxConcurrentRequests;) {
+            auto invoker = it->invoker;
+
+            if (invoker->exclusive) {
+                // Wait for preceding requests, and following requests never overtake
+                if (runningRequests.isEmpty()) {
+                    runningRequests.append(invoker);
+                    ready.append(it->invoke);
+                    pendingQueue.erase(it);
+                }
+                break;
+            }
+
+            if (!invoker->resourceKey.isEmpty()) {
+                if (busyKeys.contains(invoker->resourceKey)) {
+                    // Keep order with the preceding request for the same resource
+                    it++;
+                    continue;
+                }
+                busyKeys.insert(invoker->resourceKey);
+            }
+
+            runningRequests.append(invoker);
+            ready.append(it->invoke);
+            it = pendingQueue.erase(it);
+        }
+
+        TRACE("Dispatch requests: started=%d, pending=%d", ready.size(), pendingQueue.size());
+    }
+    locker.unlock(); // Must unlock before invoking
+
+    for (const auto &invoke : ready) {
+        invoke();
+    }
+}
+
 //--- RequestInvoker class ---//
 
-RequestInvoker::RequestInvoker(RequestSequencer *_sequencer, QObject *parent) : QObject(parent), sequencer(_sequencer)
+RequestInvoker::RequestInvoker(RequestSequencer *_sequencer, QObject *parent)
+    : QObject(parent),
+      sequencer(_sequencer),
+      exclusive(false),
+      replayed(false)
 {
-    TRACE("RequestInvoker created (Sequential)");
+    TRACE("RequestInvoker created (Scheduled)");
+}
+
+RequestInvoker::RequestInvoker(RequestSequencer *_sequencer, const QString &_resourceKey, QObject *parent)
+    : QObject(parent),
+      sequencer(_sequencer),
+      resourceKey(_resourceKey),
+      exclusive(false),
+      replayed(false)
+{
+    TRACE("RequestInvoker created (Scheduled): key=%s", qUtf8Printable(resourceKey));
 }
 
 RequestInvoker::RequestInvoker(QNetworkAccessManager *networkManager, O2 *client, QObject *parent)
     : QObject(parent),
-      sequencer(nullptr)
+      sequencer(nullptr),
+      exclusive(false),
+      replayed(false)
 {
     sequencer = new RequestSequencer(networkManager, client, this);
     TRACE("RequestInvoker created (Parallel)");
@@ -71,103 +250,118 @@ RequestInvoker::~RequestInvoker()
 
 template<class Func> void RequestInvoker::queue(Func invoker)
 {
-    QMutexLocker locker(&sequencer->mutex);
-    {
-        if (sequencer->requestQueue.isEmpty()) {
-            sequencer->requestQueue.append(this);
-            locker.unlock(); // Must unlock before invoking
-            invoker();
-            return;
-        } else {
-            // Reserve next invocation
-            connect(sequencer->requestQueue.last(), &RequestInvoker::finished, invoker);
-            sequencer->requestQueue.append(this);
-        }
-        TRACE("Queue request: size=%d", sequencer->requestQueue.size());
-    }
-    locker.unlock();
+    // Kept for replay after token refresh
+    invoke = invoker;
+    sequencer->enqueue(this, invoke);
 }
 
 void RequestInvoker::refresh()
 {
-    connect(
-        sequencer->client, SIGNAL(refreshFinished(QNetworkReply::NetworkError)), this,
-        SLOT(onO2RefreshFinished(QNetworkReply::NetworkError))
-    );
+    // The access token is replaced, other requests must not run meanwhile
+    exclusive = true;
     queue([this]() {
         TRACE("Invoke refresh token");
+        // Connect here not to take refreshFinished() of the refresh for rejected requests
+        connect(
+            sequencer->client, SIGNAL(refreshFinished(QNetworkReply::NetworkError)), this,
+            SLOT(onO2RefreshFinished(QNetworkReply::NetworkError))
+        );
         sequencer->client->refresh();
     });
 }
 
-O2Requestor *RequestInvoker::createRequestor()
+// Set the access token at the time of sending, replay must use the refreshed one
+QNetworkRequest RequestInvoker::authorize(QNetworkRequest req, int timeout)
 {
-    auto requestor = new O2Requestor(sequencer->networkManager, sequencer->client, this);
-    requestor->setAddAccessTokenInQuery(false);
-    requestor->setAccessTokenInAuthenticationHTTPHeaderFormat("Bearer %1");
-
-    connect(
-        requestor, SIGNAL(finished(int, QNetworkReply::NetworkError, QByteArray)), this,
-        SLOT(onRequestorFinished(int, QNetworkReply::NetworkError, QByteArray))
-    );
+    req.setRawHeader("Authorization", QString("Bearer %1").arg(sequencer->client->token()).toLatin1());
+    req.setTransferTimeout(timeout);
+    return req;
+}
 
-    return requestor;
+void RequestInvoker::watch(QNetworkReply *reply)
+{
+    connect(reply, &QNetworkReply::finished, this, &RequestInvoker::onReplyFinished);
 }
 
 void RequestInvoker::get(const QNetworkRequest &req, int timeout)
 {
-    queue([this, req, timeout]() { createRequestor()->get(req, timeout); });
+    queue([this, req, timeout]() { watch(sequencer->networkManager->get(authorize(req, timeout))); });
 }
 
 void RequestInvoker::post(const QNetworkRequest &req, const QByteArray &data, int timeout)
 {
-    queue([this, req, data, timeout]() { createRequestor()->post(req, data, timeout); });
+    queue([this, req, data, timeout]() { watch(sequencer->networkManager->post(authorize(req, timeout), data)); });
 }
 
 void RequestInvoker::post(const QNetworkRequest &req, QHttpMultiPart *data, int timeout)
 {
-    queue([this, req, data, timeout]() { createRequestor()->post(req, data, timeout); });
+    queue([this, req, data, timeout]() { watch(sequencer->networkManager->post(authorize(req, timeout), data)); });
 }
 
 void RequestInvoker::put(const QNetworkRequest &req, const QByteArray &data, int timeout)
 {
-    queue([this, req, data, timeout]() { createRequestor()->put(req, data, timeout); });
+    requestData = data;
+    queue([this, req, timeout]() { watch(sequencer->networkManager->put(authorize(req, timeout), requestData)); });
 }
 
 void RequestInvoker::put(const QNetworkRequest &req, QHttpMultiPart *data, int timeout)
 {
-    queue([this, req, data, timeout]() { createRequestor()->put(req, data, timeout); });
+    queue([this, req, data, timeout]() { watch(sequencer->networkManager->put(authorize(req, timeout), data)); });
+}
+
+bool RequestInvoker::supersede(const QByteArray &data)
+{
+    QMutexLocker locker(&sequencer->mutex);
+    {
+        if (!sequencer->isLastPending(this)) {
+            return false;
+        }
+        requestData = data;
+        TRACE("Request superseded: key=%s", qUtf8Printable(resourceKey));
+    }
+    locker.unlock();
+
+    return true;
 }
 
 void RequestInvoker::deleteResource(const QNetworkRequest &req, int timeout)
 {
-    queue([this, req, timeout]() { createRequestor()->deleteResource(req, timeout); });
+    queue([this, req, timeout]() { watch(sequencer->networkManager->deleteResource(authorize(req, timeout))); });
 }
 
 void RequestInvoker::head(const QNetworkRequest &req, int timeout)
 {
-    queue([this, req, timeout]() { createRequestor()->head(req, timeout); });
+    queue([this, req, timeout]() { watch(sequencer->networkManager->head(authorize(req, timeout))); });
 }
 
 void RequestInvoker::customRequest(
     const QNetworkRequest &req, const QByteArray &verb, const QByteArray &data, int timeout
 )
 {
-    queue([this, req, verb, data, timeout]() { createRequestor()->customRequest(req, verb, data, timeout); });
+    queue([this, req, verb, data, timeout]() {
+        watch(sequencer->networkManager->sendCustomRequest(authorize(req, timeout), verb, data));
+    });
 }
 
-void RequestInvoker::onRequestorFinished(int _requestId, QNetworkReply::NetworkError error, QByteArray data)
+void RequestInvoker::onReplyFinished()
 {
-    UNUSED_PARAMETER(_requestId);
-    TRACE("Request finished: %d", _requestId);
-
-    QMutexLocker locker(&sequencer->mutex);
-    {
-        sequencer->requestQueue.removeOne(this);
+    auto reply = qobject_cast<QNetworkReply *>(sender());
+    auto error = reply->error();
+    auto status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    auto data = reply->readAll();
+    reply->deleteLater();
+    TRACE("Request finished: %d", status);
+
+    if (status == 401 && !replayed && !sequencer->client->refreshToken().isEmpty()) {
+        // The sequencer refreshes the token and invokes again
+        replayed = true;
+        sequencer->replayAfterRefresh(this, invoke);
+        return;
     }
-    locker.unlock();
 
+    // Emit before releasing, so that follow-up requests queued by handlers keep order
     emit finished(error, data);
+    sequencer->release(this);
     deleteLater();
 }
 
@@ -179,12 +373,7 @@ void RequestInvoker::onO2RefreshFinished(QNetworkReply::NetworkError error)
         TRACE("Refresh finished");
     }
 
-    QMutexLocker locker(&sequencer->mutex);
-    {
-        sequencer->requestQueue.removeOne(this);
-    }
-    locker.unlock();
-
     emit finished(error, nullptr);
+    sequencer->release(this);
     deleteLater();
 }
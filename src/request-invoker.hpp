@@ -21,43 +21,83 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #include <QObject>
 #include <QMutex>
 #include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QHttpMultiPart>
 
 #include <o2.h>
-#include <o2requestor.h>
+
+#include <functional>
 
 #define DEFAULT_TIMEOUT_MSECS (10 * 1000)
+#define DEFAULT_MAX_CONCURRENT_REQUESTS 4
 
 class RequestInvoker;
 
-// This class introduces sequencial invocation of requests
+// This class schedules invocation of requests with concurrency limit.
+// Requests which have same resource key are invoked sequentially in queued order,
+// and exclusive requests (e.g. token refresh) wait for all preceding requests and block following ones.
+// Requests rejected with 401 share single token refresh, new requests are held until it finishes,
+// and then the rejected requests are replayed ahead of them.
 class RequestSequencer : public QObject {
     Q_OBJECT
 
     friend class RequestInvoker;
 
+    struct PendingRequest {
+        RequestInvoker *invoker;
+        std::function<void()> invoke;
+    };
+
     QNetworkAccessManager *networkManager;
     O2 *client;
-    QList<RequestInvoker *> requestQueue;
+    int maxConcurrentRequests;
+    QList<PendingRequest> pendingQueue;
+    QList<RequestInvoker *> runningRequests;
+    QList<PendingRequest> replayQueue; // Rejected with 401, waiting for the token refresh
+    bool refreshing;
     QMutex mutex;
 
+    void enqueue(RequestInvoker *invoker, const std::function<void()> &invoke);
+    bool isLastPending(RequestInvoker *invoker);
+    void release(RequestInvoker *invoker);
+    void replayAfterRefresh(RequestInvoker *invoker, const std::function<void()> &invoke);
+    void dispatch();
+
+private slots:
+    void onO2RefreshFinished(QNetworkReply::NetworkError error);
+
 public:
-    explicit RequestSequencer(QNetworkAccessManager *networkManager, O2 *client, QObject *parent = nullptr);
+    explicit RequestSequencer(
+        QNetworkAccessManager *networkManager, O2 *client, QObject *parent = nullptr,
+        int maxConcurrentRequests = DEFAULT_MAX_CONCURRENT_REQUESTS
+    );
     ~RequestSequencer();
 };
 
-// This class contains O2Requestor individually
+// This class sends a request with the access token of O2
 class RequestInvoker : public QObject {
     Q_OBJECT
 
+    friend class RequestSequencer;
+
     RequestSequencer *sequencer;
-    O2Requestor *createRequestor();
+    QString resourceKey; // Empty means no ordering constraint
+    bool exclusive;
+    bool replayed; // Replayed once after token refresh
+    QByteArray requestData; // Can be replaced until sent
+    std::function<void()> invoke;
+
+    QNetworkRequest authorize(QNetworkRequest req, int timeout);
+    void watch(QNetworkReply *reply);
 
 signals:
     void finished(QNetworkReply::NetworkError error, QByteArray data);
 
 public:
-    // Sequential invocation
+    // Scheduled invocation
     explicit RequestInvoker(RequestSequencer *sequencer, QObject *parent = nullptr);
+    // Scheduled invocation, ordered with other requests for the same resource key
+    explicit RequestInvoker(RequestSequencer *sequencer, const QString &resourceKey, QObject *parent = nullptr);
 
     // Parallel invocation
     explicit RequestInvoker(QNetworkAccessManager *networkManager, O2 *client, QObject *parent = nullptr);
@@ -80,6 +120,13 @@ public:
     void put(const QNetworkRequest &req, const QByteArray &data, int timeout = DEFAULT_TIMEOUT_MSECS);
     void put(const QNetworkRequest &req, QHttpMultiPart *data, int timeout = DEFAULT_TIMEOUT_MSECS);
 
+    /// Replace data of the queued request if it hasn't been sent yet and no other request for the same resource
+    /// is queued after it. Returns false if the request cannot be superseded.
+    bool supersede(const QByteArray &data);
+
+    /// Data of the request actually sent, reflects the latest supersede().
+    inline const QByteArray &getRequestData() const { return requestData; }
+
     /// Make a DELETE request.
     void deleteResource(const QNetworkRequest &req, int timeout = DEFAULT_TIMEOUT_MSECS);
 
@@ -92,6 +139,6 @@ public:
     );
 
 private slots:
-    void onRequestorFinished(int, QNetworkReply::NetworkError error, QByteArray data);
+    void onReplyFinished();
     void onO2RefreshFinished(QNetworkReply::NetworkError error);
 };
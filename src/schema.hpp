@@ -31,6 +31,7 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #include <QJsonArray>
 #include <QDateTime>
 #include <QMap>
+#include <QHash>
 #include <QJsonDocument>
 
 template<typename T> class TypedJsonArray : public QJsonArray {
@@ -79,6 +80,102 @@ public:
     T operator[](qsizetype i) const { return at(i).toObject(); }
 };
 
+// ID-indexed store of typed JSON objects which keeps insertion order.
+// Upsert and remove are O(1), the array representation is rebuilt only when it is requested after changes.
+template<typename T> class TypedJsonStore {
+    struct Entry {
+        T item;
+        quint64 seq;
+    };
+
+    QHash<QString, Entry> entries;
+    QList<QPair<quint64, QString>> order; // May contain stale (removed or re-added) elements
+    quint64 nextSeq = 0;
+    mutable TypedJsonArray<T> array;
+    mutable bool dirty = false;
+
+    void compact()
+    {
+        QList<QPair<quint64, QString>> compacted;
+        compacted.reserve(entries.size());
+        for (const auto &element : order) {
+            auto it = entries.constFind(element.second);
+            if (it != entries.constEnd() && it->seq == element.first) {
+                compacted.append(element);
+            }
+        }
+        order = compacted;
+    }
+
+public:
+    TypedJsonStore() = default;
+    TypedJsonStore(const TypedJsonArray<T> &_array) { reset(_array); }
+
+    void reset(const TypedJsonArray<T> &_array)
+    {
+        clear();
+        foreach (const QJsonValue item, _array) {
+            upsert(item.toObject());
+        }
+    }
+
+    void clear()
+    {
+        entries.clear();
+        order.clear();
+        array = TypedJsonArray<T>();
+        dirty = false;
+    }
+
+    // Returns true if the item is newly inserted
+    bool upsert(const T &item)
+    {
+        auto id = item.getId();
+        auto it = entries.find(id);
+        dirty = true;
+        if (it != entries.end()) {
+            it->item = item;
+            return false;
+        }
+        entries.insert(id, {item, nextSeq});
+        order.append({nextSeq++, id});
+        return true;
+    }
+
+    bool remove(const QString &id)
+    {
+        if (!entries.remove(id)) {
+            return false;
+        }
+        dirty = true;
+        if (order.size() > entries.size() * 2 + 16) {
+            compact();
+        }
+        return true;
+    }
+
+    inline bool contains(const QString &id) const { return entries.contains(id); }
+    inline const T value(const QString &id) const { return entries.value(id, {T(), 0}).item; }
+    inline qsizetype size() const { return entries.size(); }
+    inline bool isEmpty() const { return entries.isEmpty(); }
+
+    const TypedJsonArray<T> &toArray() const
+    {
+        if (dirty) {
+            QJsonArray rebuilt;
+            for (const auto &element : order) {
+                auto it = entries.constFind(element.second);
+                if (it != entries.constEnd() && it->seq == element.first) {
+                    rebuilt.append(it->item);
+                }
+            }
+            array = rebuilt;
+            dirty = false;
+        }
+        return array;
+    }
+};
+
 inline bool maybe(const QJsonValue &value, bool result)
 {
     return value.isNull() || value.isUndefined() || result;
@@ -1507,6 +1604,18 @@ public:
     inline void setDroppedFrames(int value) { insert("dropped_frames", value); }
     inline qint64 getTotalSize() const { return value("total_size").toInteger(); }
     inline void setTotalSize(qint64 value) { insert("total_size", value); }
+    // Following values are optional
+    inline double getCongestion() const { return value("congestion").toDouble(); }
+    inline void setCongestion(double value) { insert("congestion", value); }
+    inline int getConnectTime() const { return value("connect_time").toInt(); }
+    inline void setConnectTime(int value) { insert("connect_time", value); }
+    inline double getActivationLatency() const { return value("activation_latency").toDouble(); }
+    inline void setActivationLatency(double value) { insert("activation_latency", value); }
+    inline int getSkippedFrames() const { return value("skipped_frames").toInt(); }
+    inline void setSkippedFrames(int value) { insert("skipped_frames", value); }
+    // From the encoder settings, not measured from packets
+    inline int getConfiguredKeyframeInterval() const { return value("configured_keyframe_interval").toInt(); }
+    inline void setConfiguredKeyframeInterval(int value) { insert("configured_keyframe_interval", value); }
 
     inline bool isValid() const
     {
@@ -75,9 +75,17 @@ public:
     {
         setValue("egress.screenshotInterval", QString::number(value));
     }
+    inline int getEgressAudioTargetLatency() { return value("egress.audioTargetLatency", "50").toInt(); }
+    inline bool getEgressPrewarmStandBy() { return value("egress.prewarmStandBy", "false") == "true"; }
+    inline void setEgressPrewarmStandBy(bool value)
+    {
+        setValue("egress.prewarmStandBy", value ? "true" : "false");
+    }
     inline bool getEgressPreferHardwareEncoder() { return value("egress.preferHardwareEncoder", "true") == "true"; }
     inline void setEgressPreferHardwareEncoder(bool value)
     {
         setValue("egress.preferHardwareEncoder", value ? "true" : "false");
     }
+
+    inline int getNetworkPingInterval() { return value("network.pingInterval", "5").toInt(); }
 };
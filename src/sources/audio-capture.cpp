@@ -17,11 +17,128 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 */
 
 #include <obs-module.h>
+#include <util/platform.h>
+
+#include <algorithm>
 
 #include "audio-capture.hpp"
 #include "../plugin-support.h"
 
 #define MAX_AUDIO_BUFFER_FRAMES 131071
+#define AUDIO_RING_CHUNKS 4096
+
+//--- AudioRingBuffer class ---//
+
+AudioRingBuffer::AudioRingBuffer(size_t _channels, size_t _capacity, size_t _chunkCapacity)
+    : channels(_channels),
+      capacity(_capacity),
+      chunkCapacity(_chunkCapacity),
+      planes{nullptr},
+      writePos(0),
+      readPos(0),
+      chunkWritePos(0),
+      chunkReadPos(0),
+      droppedFrames(0)
+{
+    // Allocate everything up front, neither side allocates afterwards
+    for (size_t ch = 0; ch < channels; ch++) {
+        planes[ch] = (float *)bzalloc(capacity * sizeof(float));
+    }
+    chunks = (Chunk *)bzalloc(chunkCapacity * sizeof(Chunk));
+}
+
+AudioRingBuffer::~AudioRingBuffer()
+{
+    for (size_t ch = 0; ch < channels; ch++) {
+        bfree(planes[ch]);
+    }
+    bfree(chunks);
+}
+
+bool AudioRingBuffer::write(uint8_t *const *data, uint32_t frames, uint64_t timestamp)
+{
+    if (!frames) {
+        return true;
+    }
+
+    auto wpos = writePos.load(std::memory_order_relaxed);
+    auto rpos = readPos.load(std::memory_order_acquire);
+    auto cwpos = chunkWritePos.load(std::memory_order_relaxed);
+    auto crpos = chunkReadPos.load(std::memory_order_acquire);
+
+    if (capacity - (size_t)(wpos - rpos) < frames || cwpos - crpos >= chunkCapacity) {
+        droppedFrames.fetch_add(frames, std::memory_order_relaxed);
+        return false;
+    }
+
+    auto index = (size_t)(wpos & (capacity - 1));
+    auto first = std::min((size_t)frames, capacity - index);
+
+    for (size_t ch = 0; ch < channels; ch++) {
+        if (!data[ch]) {
+            // Unused channel
+            memset(planes[ch] + index, 0, first * sizeof(float));
+            memset(planes[ch], 0, (frames - first) * sizeof(float));
+            continue;
+        }
+        auto in = (const float *)data[ch];
+        memcpy(planes[ch] + index, in, first * sizeof(float));
+        memcpy(planes[ch], in + first, (frames - first) * sizeof(float));
+    }
+
+    chunks[cwpos & (chunkCapacity - 1)] = {wpos, timestamp, frames};
+
+    // Publish chunk marker before frames so that consumer always finds a marker for readable frames
+    chunkWritePos.store(cwpos + 1, std::memory_order_release);
+    writePos.store(wpos + frames, std::memory_order_release);
+
+    return true;
+}
+
+size_t AudioRingBuffer::getReadableFrames() const
+{
+    return (size_t)(writePos.load(std::memory_order_acquire) - readPos.load(std::memory_order_relaxed));
+}
+
+const float *AudioRingBuffer::peek(size_t channel, size_t offset, size_t *contiguousFrames) const
+{
+    auto rpos = readPos.load(std::memory_order_relaxed) + offset;
+    auto readable = (size_t)(writePos.load(std::memory_order_acquire) - rpos);
+    auto index = (size_t)(rpos & (capacity - 1));
+
+    *contiguousFrames = std::min(readable, capacity - index);
+    return planes[channel] + index;
+}
+
+bool AudioRingBuffer::peekChunk(Chunk *chunk) const
+{
+    auto crpos = chunkReadPos.load(std::memory_order_relaxed);
+    if (crpos == chunkWritePos.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    *chunk = chunks[crpos & (chunkCapacity - 1)];
+    return true;
+}
+
+void AudioRingBuffer::consume(size_t frames)
+{
+    auto rpos = readPos.load(std::memory_order_relaxed) + frames;
+
+    // Retire chunk markers which have been fully consumed
+    auto crpos = chunkReadPos.load(std::memory_order_relaxed);
+    auto cwpos = chunkWritePos.load(std::memory_order_acquire);
+    while (crpos < cwpos) {
+        const auto &chunk = chunks[crpos & (chunkCapacity - 1)];
+        if (chunk.position + chunk.frames > rpos) {
+            break;
+        }
+        crpos++;
+    }
+
+    chunkReadPos.store(crpos, std::memory_order_release);
+    readPos.store(rpos, std::memory_order_release);
+}
 
 //--- SourceAudioCapture class ---//
 
@@ -32,11 +149,17 @@ SourceAudioCapture::SourceAudioCapture(
       weakSource(obs_source_get_weak_source(source)),
       samplesPerSec(_samplesPerSec),
       speakers(_speakers),
-      audioBuffer({0}),
-      audioBufferFrames(0),
-      audioConvBuffer(nullptr),
-      audioConvBufferSize(0)
+      audioRing(get_audio_channels(_speakers), MAX_AUDIO_BUFFER_FRAMES + 1, AUDIO_RING_CHUNKS),
+      audioNotifier(nullptr),
+      notifyPending(false),
+      active(false),
+      overflowed(false),
+      pushCount(0),
+      pushTotalNs(0),
+      pushMaxNs(0)
 {
+    os_sem_init(&audioNotifier, 0);
+
     obs_source_add_audio_capture_callback(source, onSourceAudio, this);
     obs_log(LOG_DEBUG, "%s: Source audio capture created.", obs_source_get_name(source));
 }
@@ -46,66 +169,55 @@ SourceAudioCapture::~SourceAudioCapture()
     OBSSourceAutoRelease source = obs_weak_source_get_source(weakSource);
     obs_source_remove_audio_capture_callback(source, onSourceAudio, this);
 
-    deque_free(&audioBuffer);
-    bfree(audioConvBuffer);
+    // The callback has been removed, producer no longer posts
+    os_sem_destroy(audioNotifier);
 
     obs_log(LOG_DEBUG, "%s: Source audio capture destroyed.", obs_source_get_name(source));
 }
 
+void SourceAudioCapture::waitAudio()
+{
+    os_sem_wait(audioNotifier);
+    // Clear before the consumer drains, chunks pushed from now on post again
+    notifyPending.store(false);
+}
+
+void SourceAudioCapture::wakeUp()
+{
+    os_sem_post(audioNotifier);
+}
+
+// Called from OBS's audio thread: Never blocks nor allocates
 void SourceAudioCapture::pushAudio(const audio_data *audioData, obs_source_t *source)
 {
     if (!active) {
         return;
     }
 
-    QMutexLocker locker(&audioBufferMutex);
-    {
-        // Push audio data to buffer
-        if (audioBufferFrames + audioData->frames > MAX_AUDIO_BUFFER_FRAMES) {
-            obs_log(LOG_WARNING, "%s: The audio buffer is full", obs_source_get_name(source));
-            deque_free(&audioBuffer);
-            deque_init(&audioBuffer);
-            audioBufferFrames = 0;
-        }
-
-        // Compute header
-        AudioBufferHeader header = {0};
-        header.frames = audioData->frames;
-        header.timestamp = audioData->timestamp;
-        header.samples_per_sec = samplesPerSec;
-        header.speakers = speakers;
-        header.format = AUDIO_FORMAT_FLOAT_PLANAR;
-
-        for (auto i = 0, channels = 0; i < header.speakers; i++) {
-            if (!audioData->data[i]) {
-                continue;
-            }
-            header.data_idx[i] = sizeof(AudioBufferHeader) + channels * audioData->frames * 4;
-            channels++;
-        }
+    auto startedAt = os_gettime_ns();
 
-        // Push audio data to buffer
-        deque_push_back(&audioBuffer, &header, sizeof(AudioBufferHeader));
-        for (auto i = 0; i < header.speakers; i++) {
-            if (!audioData->data[i]) {
-                continue;
-            }
-            deque_push_back(&audioBuffer, audioData->data[i], audioData->frames * 4);
+    if (!audioRing.write(audioData->data, audioData->frames, audioData->timestamp)) {
+        // Drop incoming frames because consumer owns read position
+        if (!overflowed) {
+            obs_log(LOG_WARNING, "%s: The audio buffer is full", obs_source_get_name(source));
+            overflowed = true;
         }
+    } else {
+        overflowed = false;
 
-        auto dataSize = sizeof(AudioBufferHeader) + header.speakers * header.frames * 4;
-        if (dataSize > audioConvBufferSize) {
-            obs_log(
-                LOG_DEBUG, "%s: Expand audioConvBuffer from %zu to %zu bytes", obs_source_get_name(source),
-                audioConvBufferSize, dataSize
-            );
-            audioConvBuffer = (uint8_t *)brealloc(audioConvBuffer, dataSize);
-            audioConvBufferSize = dataSize;
+        // Wake up consumer once, it drains every chunk pushed until then
+        if (!notifyPending.exchange(true)) {
+            os_sem_post(audioNotifier);
         }
+    }
 
-        audioBufferFrames += audioData->frames;
+    // Only producer updates these, relaxed read-modify-write is enough
+    auto elapsed = os_gettime_ns() - startedAt;
+    pushCount.fetch_add(1, std::memory_order_relaxed);
+    pushTotalNs.fetch_add(elapsed, std::memory_order_relaxed);
+    if (elapsed > pushMaxNs.load(std::memory_order_relaxed)) {
+        pushMaxNs.store(elapsed, std::memory_order_relaxed);
     }
-    locker.unlock();
 }
 
 // Callback from obs_source_add_audio_capture_callback
@@ -20,10 +20,54 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 
 #include <obs-module.h>
 #include <obs.hpp>
-#include <util/deque.h>
+#include <util/threading.h>
 
 #include <QObject>
-#include <QMutex>
+
+#include <atomic>
+
+// Wait-free single-producer/single-consumer ring of planar float samples.
+// The producer is OBS's audio capture callback, the consumer is the output/ingress audio thread.
+class AudioRingBuffer {
+public:
+    struct Chunk {
+        uint64_t position; // Absolute frame position of the first frame
+        uint64_t timestamp;
+        uint32_t frames;
+    };
+
+private:
+    size_t channels;
+    size_t capacity; // Frames per channel (power of 2)
+    size_t chunkCapacity;
+    float *planes[MAX_AV_PLANES];
+    Chunk *chunks;
+
+    // Absolute positions, wrap by mask
+    std::atomic<uint64_t> writePos;
+    std::atomic<uint64_t> readPos;
+    std::atomic<uint64_t> chunkWritePos;
+    std::atomic<uint64_t> chunkReadPos;
+    std::atomic<uint64_t> droppedFrames;
+
+public:
+    explicit AudioRingBuffer(size_t _channels, size_t _capacity, size_t _chunkCapacity);
+    ~AudioRingBuffer();
+
+    // Producer side: Returns false when the ring has no room (incoming frames are dropped)
+    bool write(uint8_t *const *data, uint32_t frames, uint64_t timestamp);
+
+    // Consumer side
+    size_t getReadableFrames() const;
+    inline uint64_t getReadPosition() const { return readPos.load(std::memory_order_relaxed); }
+    const float *peek(size_t channel, size_t offset, size_t *contiguousFrames) const;
+    bool peekChunk(Chunk *chunk) const;
+    void consume(size_t frames);
+
+    inline size_t getChannels() const { return channels; }
+    inline size_t getCapacity() const { return capacity; }
+    inline uint64_t getDroppedFrames() const { return droppedFrames.load(std::memory_order_relaxed); }
+};
 
 class SourceAudioCapture : public QObject {
     Q_OBJECT
@@ -34,24 +78,19 @@ protected:
     uint32_t samplesPerSec;
     speaker_layout speakers;
 
-    deque audioBuffer;
-    size_t audioBufferFrames;
-    uint8_t *audioConvBuffer;
-    size_t audioConvBufferSize;
-    QMutex audioBufferMutex;
-    bool active;
+    AudioRingBuffer audioRing;
+    // Posted only when no wake-up is pending, os_sem_post() never takes a user-space lock
+    os_sem_t *audioNotifier;
+    std::atomic<bool> notifyPending;
+    std::atomic<bool> active;
+    bool overflowed; // Touched by producer only
 
-public:
-    struct AudioBufferHeader {
-        size_t data_idx[MAX_AV_PLANES]; // Zero means unused channel
-        uint32_t frames;
-        speaker_layout speakers;
-        audio_format format;
-        uint32_t samples_per_sec;
-        uint64_t timestamp;
-        size_t offset;
-    };
+    // Producer-side contention metrics (nanoseconds spent in pushAudio)
+    std::atomic<uint64_t> pushCount;
+    std::atomic<uint64_t> pushTotalNs;
+    std::atomic<uint64_t> pushMaxNs;
 
+public:
     explicit SourceAudioCapture(
         obs_source_t *source, uint32_t _samplesPerSec, speaker_layout _speakers, QObject *parent = nullptr
     );
@@ -60,11 +99,15 @@ public:
     void pushAudio(const audio_data *audioData, obs_source_t *source);
     inline bool getActive() { return active; }
     inline void setActive(bool value) { active = value; }
-    inline QMutex *getAudioBufferMutex() { return &audioBufferMutex; }
-    inline deque *getAudioBuffer() { return &audioBuffer; }
-    inline uint8_t *getAudioConvBuffer() const { return audioConvBuffer; }
-    inline size_t getAudioBufferFrames() const { return audioBufferFrames; }
-    inline void decrementAudioBufferFrames(size_t amount) { audioBufferFrames -= amount; }
+    inline AudioRingBuffer *getAudioRing() { return &audioRing; }
+    // Consumer side: Blocks until chunks have been pushed since the last call or wakeUp() is called
+    void waitAudio();
+    void wakeUp();
+    inline uint32_t getSamplesPerSec() const { return samplesPerSec; }
+    inline speaker_layout getSpeakers() const { return speakers; }
+    inline uint64_t getPushCount() const { return pushCount.load(std::memory_order_relaxed); }
+    inline uint64_t getPushTotalNs() const { return pushTotalNs.load(std::memory_order_relaxed); }
+    inline uint64_t getPushMaxNs() const { return pushMaxNs.load(std::memory_order_relaxed); }
 
 private:
     static void onSourceAudio(void *param, obs_source_t *, const audio_data *audioData, bool muted);
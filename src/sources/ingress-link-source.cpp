@@ -22,6 +22,8 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #include <QUrlQuery>
 #include <QJsonDocument>
 
+#include <algorithm>
+
 #include "../plugin-support.h"
 #include "../utils.hpp"
 #include "ingress-link-source.hpp"
@@ -101,6 +103,14 @@ IngressLinkSource::IngressLinkSource(
         SLOT(onDeleteDownlinkSucceeded(const QString &))
     );
     connect(apiClient, SIGNAL(stagesReady(const StageArray &)), this, SLOT(onStagesReady(const StageArray &)));
+    connect(
+        apiClient, SIGNAL(stageAdded(const QString &, const Stage &)), this,
+        SLOT(onStageChanged(const QString &, const Stage &))
+    );
+    connect(
+        apiClient, SIGNAL(stageChanged(const QString &, const Stage &)), this,
+        SLOT(onStageChanged(const QString &, const Stage &))
+    );
     connect(apiClient, &SRCLinkApiClient::licenseChanged, [this](const SubscriptionLicense &license) {
         if (license.getLicenseValid()) {
             reactivate();
@@ -188,7 +198,7 @@ void IngressLinkSource::stopAudio()
     }
 
     // Destroy decoder private source
-    audioThread->requestInterruption();
+    audioThread->stop();
     audioThread->wait();
     delete audioThread;
     audioThread = nullptr;
@@ -613,14 +623,26 @@ void IngressLinkSource::onSettingsUpdate(obs_data_t *settings)
     obs_log(LOG_DEBUG, "%s: Source updating", qUtf8Printable(name));
 
     captureSettings(settings);
-    connect(putConnection(), &RequestInvoker::finished, [this, settings](QNetworkReply::NetworkError error, QByteArray) {
+    auto invoker = putConnection();
+    if (!invoker || invoker == settingsPut) {
+        // The queued request has been superseded, its handler is connected already
+        return;
+    }
+    settingsPut = invoker;
+
+    connect(invoker, &RequestInvoker::finished, [this](QNetworkReply::NetworkError error, QByteArray) {
         if (error != QNetworkReply::NoError) {
             obs_log(LOG_ERROR, "%s: Source update failed", qUtf8Printable(name));
             return;
         }
 
         // Store settings to file as recently settings.
-        saveSettings(settings);
+        // The settings passed to onSettingsUpdate() may be released already, and later updates may be sent instead.
+        OBSSourceAutoRelease source = obs_weak_source_get_source(weakSource);
+        if (source) {
+            OBSDataAutoRelease settings = obs_source_get_settings(source);
+            saveSettings(settings);
+        }
 
         obs_log(LOG_INFO, "%s: Source updated", qUtf8Printable(name));
     });
@@ -708,6 +730,15 @@ void IngressLinkSource::onStagesReady(const StageArray &stages)
     putConnection();
 }
 
+void IngressLinkSource::onStageChanged(const QString &id, const Stage &stage)
+{
+    // Only the selected stage matters
+    if (id != connRequest.getStageId()) {
+        return;
+    }
+    onStagesReady(StageArray(QJsonArray({stage})));
+}
+
 // This is called when link or refresh token succeeded
 void IngressLinkSource::onLoginSucceeded()
 {
@@ -745,75 +776,110 @@ void IngressLinkSource::updateCallback(obs_data_t *settings)
 SourceAudioThread::SourceAudioThread(IngressLinkSource *_linkedSource, QObject *parent)
     : QThread(parent),
       ingressLinkSource(_linkedSource),
-      audioCapture(_linkedSource->decoderSource, _linkedSource->samplesPerSec, _linkedSource->speakers)
+      audioCapture(_linkedSource->decoderSource, _linkedSource->samplesPerSec, _linkedSource->speakers),
+      convBuffer(nullptr),
+      convBufferSize(0)
 {
+    // Pre-allocate for typical chunk size, grows in run() if the decoder delivers larger chunks
+    convBufferSize = audioCapture.getAudioRing()->getChannels() * AUDIO_OUTPUT_FRAMES * sizeof(float);
+    convBuffer = (uint8_t *)bmalloc(convBufferSize);
     obs_log(LOG_DEBUG, "%s: Audio thread creating.", qUtf8Printable(ingressLinkSource->name));
 }
 
 SourceAudioThread::~SourceAudioThread()
 {
     if (isRunning()) {
-        requestInterruption();
+        stop();
         wait();
     }
 
+    bfree(convBuffer);
+
     obs_log(LOG_DEBUG, "%s: Audio thread destroyed.", qUtf8Printable(ingressLinkSource->name));
 }
 
+void SourceAudioThread::stop()
+{
+    requestInterruption();
+    // Wake up run() blocked in waitAudio()
+    audioCapture.wakeUp();
+}
+
 void SourceAudioThread::run()
 {
     obs_log(LOG_DEBUG, "%s: Audio thread started.", qUtf8Printable(ingressLinkSource->name));
     audioCapture.setActive(true);
 
+    auto audioRing = audioCapture.getAudioRing();
+    auto channels = std::min(audioRing->getChannels(), (size_t)MAX_AV_PLANES);
+
     while (!isInterruptionRequested()) {
-        QMutexLocker locker(audioCapture.getAudioBufferMutex());
-        {
-            OBSSourceAutoRelease source = obs_weak_source_get_source(ingressLinkSource->weakSource);
-            if (!source) {
-                break;
-            }
-            if (!audioCapture.getAudioBufferFrames()) {
-                // No data at this time
-                locker.unlock();
-                msleep(10);
-                continue;
-            }
+        // Sleep until pushAudio() signals chunks or stop() wakes up
+        audioCapture.waitAudio();
+        if (isInterruptionRequested()) {
+            break;
+        }
 
-            // Peek header of first chunk
-            deque_peek_front(
-                audioCapture.getAudioBuffer(), audioCapture.getAudioConvBuffer(),
-                sizeof(SourceAudioCapture::AudioBufferHeader)
-            );
-            auto header = (SourceAudioCapture::AudioBufferHeader *)audioCapture.getAudioConvBuffer();
-            size_t dataSize = sizeof(SourceAudioCapture::AudioBufferHeader) + header->speakers * header->frames * 4;
+        // Resolve the source once per wake-up and drain all pushed chunks with it
+        OBSSourceAutoRelease source = obs_weak_source_get_source(ingressLinkSource->weakSource);
+        if (!source) {
+            break;
+        }
 
-            // Read chunk data
-            deque_pop_front(audioCapture.getAudioBuffer(), audioCapture.getAudioConvBuffer(), dataSize);
+        AudioRingBuffer::Chunk chunk;
+        // The front chunk might not be published entirely yet, pushAudio() signals again once it is
+        while (!isInterruptionRequested() && audioRing->peekChunk(&chunk) &&
+               audioRing->getReadableFrames() >= chunk.frames) {
+
+            // Copy chunk out of the ring (It might wrap around)
+            auto dataSize = channels * chunk.frames * sizeof(float);
+            if (dataSize > convBufferSize) {
+                obs_log(
+                    LOG_DEBUG, "%s: Expand audio conversion buffer from %zu to %zu bytes",
+                    qUtf8Printable(ingressLinkSource->name), convBufferSize, dataSize
+                );
+                convBuffer = (uint8_t *)brealloc(convBuffer, dataSize);
+                convBufferSize = dataSize;
+            }
 
             // Create audio data to send source output
             obs_source_audio audioData = {0};
-            audioData.frames = header->frames;
-            audioData.timestamp = header->timestamp;
-            audioData.speakers = header->speakers;
-            audioData.format = header->format;
-            audioData.samples_per_sec = header->samples_per_sec;
-
-            for (int i = 0; i < header->speakers; i++) {
-                if (!header->data_idx[i]) {
-                    continue;
+            audioData.frames = chunk.frames;
+            audioData.timestamp = chunk.timestamp;
+            audioData.speakers = audioCapture.getSpeakers();
+            audioData.format = AUDIO_FORMAT_FLOAT_PLANAR;
+            audioData.samples_per_sec = audioCapture.getSamplesPerSec();
+
+            for (size_t ch = 0; ch < channels; ch++) {
+                auto out = (float *)convBuffer + ch * chunk.frames;
+                size_t copied = 0;
+                while (copied < chunk.frames) {
+                    size_t frames = 0;
+                    auto in = audioRing->peek(ch, copied, &frames);
+                    frames = std::min(frames, (size_t)chunk.frames - copied);
+                    memcpy(out + copied, in, frames * sizeof(float));
+                    copied += frames;
                 }
-                audioData.data[i] = audioCapture.getAudioConvBuffer() + header->data_idx[i];
+                audioData.data[ch] = (uint8_t *)out;
             }
 
+            // Release ring space before output, the producer never waits on OBS's audio path
+            audioRing->consume(chunk.frames);
+
             // Send data to source output
             obs_source_output_audio(source, &audioData);
-
-            audioCapture.decrementAudioBufferFrames(header->frames);
         }
-        locker.unlock();
     }
 
     audioCapture.setActive(false);
+
+    auto pushCount = audioCapture.getPushCount();
+    obs_log(
+        LOG_INFO, "%s: Audio producer pushes=%llu, avg=%.1fus, max=%.1fus, dropped=%llu frames",
+        qUtf8Printable(ingressLinkSource->name), (unsigned long long)pushCount,
+        pushCount ? audioCapture.getPushTotalNs() / 1000.0 / pushCount : 0.0, audioCapture.getPushMaxNs() / 1000.0,
+        (unsigned long long)audioRing->getDroppedFrames()
+    );
     obs_log(LOG_DEBUG, "%s: Audio thread stopped.", qUtf8Printable(ingressLinkSource->name));
 }
 
@@ -19,18 +19,16 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #pragma once
 
 #include <obs-module.h>
-#include <util/deque.h>
 
 #include <QObject>
 #include <QThread>
 #include <QMutex>
+#include <QPointer>
 
 #include "../api-client.hpp"
 #include "audio-capture.hpp"
 #include "image-renderer.hpp"
 
-#define MAX_AUDIO_BUFFER_FRAMES 131071
-
 class SourceAudioThread;
 
 class IngressLinkSource : public QObject {
@@ -59,6 +57,7 @@ class IngressLinkSource : public QObject {
     OBSSignal renameSignal;
     int revision;
     StageConnection connection;
+    QPointer<const RequestInvoker> settingsPut; // Superseded by following settings updates
 
     void captureSettings(obs_data_t *settings);
     // Return value must be release via obs_data_release()
@@ -82,6 +81,7 @@ private slots:
     void onDeleteDownlinkSucceeded(const QString &uuid);
     void onDownlinkReady(const DownlinkInfo &downlink);
     void onStagesReady(const StageArray &stages);
+    void onStageChanged(const QString &id, const Stage &stage);
     void onLoginSucceeded();
     void onLogoutSucceeded();
     void onSettingsUpdate(obs_data_t *settings);
@@ -108,10 +108,15 @@ class SourceAudioThread : public QThread {
 
     IngressLinkSource *ingressLinkSource;
     SourceAudioCapture audioCapture;
+    // Scratch buffer owned by this thread, chunk is copied here before output
+    uint8_t *convBuffer;
+    size_t convBufferSize;
 
 public:
     explicit SourceAudioThread(IngressLinkSource *_linkedSource, QObject *parent = nullptr);
     ~SourceAudioThread();
 
+    void stop();
+
     void run() override;
 };
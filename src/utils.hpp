@@ -175,9 +175,6 @@ inline QString QTStr(const char *lookupVal)
     return QString::fromUtf8(obs_module_text(lookupVal));
 }
 
-QImage
-takeSourceScreenshot(obs_source_t *source, bool &success, uint32_t requestedWidth = 0, uint32_t requestedHeight = 0);
-
 inline bool isPrivateIPv4(quint32 ip)
 {
     return (ip & 0xFF000000) == 0x0A000000 || (ip & 0xFFF00000) == 0xAC100000 || (ip & 0xFFFF0000) == 0xC0A80000;
@@ -72,20 +72,46 @@ void WsPortalEventHandler::broadcastEvent(
         return;
     }
 
+    QReadLocker dispatchLocker(&dispatchLock);
+
+    // Snapshot matching callbacks, then serialize and fan out without blocking other broadcasts
+    QList<WsPortalEventCallback> targets;
     QMutexLocker locker(&outputMutex);
     {
-        for (auto &cb : eventCallbacks) {
-            cb.callback(requiredIntent, eventType.c_str(), eventData.dump().c_str(), cb.priv_data);
+        for (const auto &cb : eventCallbacks) {
+            if (cb.eventSubscriptions & requiredIntent) {
+                targets.append(cb);
+            }
         }
     }
     locker.unlock();
+
+    // Don't serialize events nobody subscribes, e.g. high volume events
+    if (targets.isEmpty()) {
+        return;
+    }
+
+    json data = {{"eventType", eventType}, {"eventIntent", (int)requiredIntent}, {"eventData", eventData}};
+    json body = {{"op", 5}, {"d", data}};
+    // The body is stored in msgpack encoded binary
+    json envelope = {{"body", json::to_msgpack(body)}};
+
+    auto raw = json::to_msgpack(envelope);
+    // Implicitly shared, callbacks can pass it to other threads without copying
+    auto message = QByteArray(reinterpret_cast<const char *>(raw.data()), raw.size());
+
+    for (const auto &cb : targets) {
+        cb.callback(message, cb.privData);
+    }
 }
 
-void WsPortalEventHandler::registerEventCallback(obs_websocket_event_callback_function eventCallback, void *privData)
+void WsPortalEventHandler::registerEventCallback(
+    WsPortalEventCallbackFunction eventCallback, void *privData, uint64_t eventSubscriptions
+)
 {
     QMutexLocker locker(&outputMutex);
     {
-        obs_websocket_event_callback cb = {eventCallback, privData};
+        WsPortalEventCallback cb = {eventCallback, privData, eventSubscriptions};
         if (!eventCallbacks.contains(cb)) {
             eventCallbacks.append(cb);
         }
@@ -93,14 +119,32 @@ void WsPortalEventHandler::registerEventCallback(obs_websocket_event_callback_fu
     locker.unlock();
 }
 
-void WsPortalEventHandler::unregisterEventCallback(obs_websocket_event_callback_function eventCallback, void *privData)
+void WsPortalEventHandler::unregisterEventCallback(WsPortalEventCallbackFunction eventCallback, void *privData)
 {
     QMutexLocker locker(&outputMutex);
     {
-        obs_websocket_event_callback cb = {eventCallback, privData};
+        WsPortalEventCallback cb = {eventCallback, privData, 0};
         eventCallbacks.removeAll(cb);
     }
     locker.unlock();
+
+    // Wait for broadcasts which may still hold the callback in their snapshot
+    QWriteLocker dispatchLocker(&dispatchLock);
+}
+
+void WsPortalEventHandler::setEventSubscriptions(
+    WsPortalEventCallbackFunction eventCallback, void *privData, uint64_t eventSubscriptions
+)
+{
+    QMutexLocker locker(&outputMutex);
+    {
+        for (auto &cb : eventCallbacks) {
+            if (cb.callback == eventCallback && cb.privData == privData) {
+                cb.eventSubscriptions = eventSubscriptions;
+            }
+        }
+    }
+    locker.unlock();
 }
 
 void WsPortalEventHandler::subscribe(uint64_t eventSubscriptions)
@@ -24,6 +24,17 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #include <QObject>
 #include <QList>
 #include <QMutex>
+#include <QReadWriteLock>
+#include <QByteArray>
+
+// Receives the event message which is serialized once and shared by all callbacks
+typedef void (*WsPortalEventCallbackFunction)(const QByteArray &message, void *privData);
+
+struct WsPortalEventCallback {
+    WsPortalEventCallbackFunction callback;
+    void *privData;
+    uint64_t eventSubscriptions; // Events not matching are filtered out before serialization
+};
 
 class WsPortalEventHandler : public QObject {
     Q_OBJECT
@@ -36,8 +47,10 @@ class WsPortalEventHandler : public QObject {
 
     bool ready;
     EventHandlerPtr eventHandler;
-    QList<obs_websocket_event_callback> eventCallbacks;
+    QList<WsPortalEventCallback> eventCallbacks;
     QMutex outputMutex;
+    // Held for read while broadcasting so that unregistering waits for in-flight callbacks
+    QReadWriteLock dispatchLock;
 
     void broadcastEvent(
         uint64_t requiredIntent, const std::string &eventType, const json &eventData = nullptr, uint8_t rpcVersion = 0
@@ -51,14 +64,19 @@ public:
     static WsPortalEventHandler *getInstance();
     static void destroyInstance();
 
-    void registerEventCallback(obs_websocket_event_callback_function eventCallback, void *privData);
-    void unregisterEventCallback(obs_websocket_event_callback_function eventCallback, void *privData);
+    void registerEventCallback(
+        WsPortalEventCallbackFunction eventCallback, void *privData, uint64_t eventSubscriptions = 0
+    );
+    void unregisterEventCallback(WsPortalEventCallbackFunction eventCallback, void *privData);
+    void setEventSubscriptions(
+        WsPortalEventCallbackFunction eventCallback, void *privData, uint64_t eventSubscriptions
+    );
     void subscribe(uint64_t eventSubscriptions);
     void unsubscribe(uint64_t eventSubscriptions);
 };
 
 // Equation operator for QList
-inline bool operator==(const obs_websocket_event_callback &lhs, const obs_websocket_event_callback &rhs)
+inline bool operator==(const WsPortalEventCallback &lhs, const WsPortalEventCallback &rhs)
 {
-    return lhs.callback == rhs.callback && lhs.priv_data == rhs.priv_data;
+    return lhs.callback == rhs.callback && lhs.privData == rhs.privData;
 }
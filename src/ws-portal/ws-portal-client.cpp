@@ -26,8 +26,6 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #include "../api-client.hpp"
 #include "event-handler.hpp"
 
-#define INTERVAL_INTERVAL_MSECS 30000
-
 //#define API_DEBUG
 
 #define WS_PORTALS_PATH "/v1/ws-portals"
@@ -50,23 +48,43 @@ WsPortalClient::WsPortalClient(SRCLinkApiClient *_apiClient, QObject *parent)
       status(WS_PORTAL_STATUS_INACTIVE),
       reconnectCount(0)
 {
-    intervalTimer = new QTimer(this);
+    reconnectTimer = new QTimer(this);
+    reconnectTimer->setSingleShot(true);
 
     connect(apiClient, SIGNAL(ready(bool)), this, SLOT(onApiClientReady(bool)));
     connect(
         apiClient, SIGNAL(wsPortalsReady(const WsPortalArray &)), this, SLOT(onWsPortalsReady(const WsPortalArray &))
     );
+    connect(
+        apiClient, SIGNAL(wsPortalAdded(const QString &, const WsPortal &)), this,
+        SLOT(onWsPortalChanged(const QString &, const WsPortal &))
+    );
+    connect(
+        apiClient, SIGNAL(wsPortalChanged(const QString &, const WsPortal &)), this,
+        SLOT(onWsPortalChanged(const QString &, const WsPortal &))
+    );
+    connect(apiClient, SIGNAL(wsPortalRemoved(const QString &)), this, SLOT(onWsPortalRemoved(const QString &)));
     connect(apiClient, SIGNAL(logoutSucceeded()), this, SLOT(onLogoutSucceeded()));
     connect(apiClient, SIGNAL(loginFailed()), this, SLOT(onLogoutSucceeded()));
 
-    // Setup interval timer for pinging
-    connect(intervalTimer, &QTimer::timeout, [this]() {
-        if (status == WS_PORTAL_STATUS_ACTIVE && client && client->isValid()) {
-            client->ping();
+    // Setup health monitor for pinging, the socket is attached on creation
+    healthMonitor =
+        new LinkHealthMonitor("ws-portal", apiClient->getSettings()->getNetworkPingInterval() * 1000, this);
+    connect(healthMonitor, &LinkHealthMonitor::unresponsive, this, [this]() {
+        if (client) {
+            // Half-open connection, disconnected() triggers reconnection
+            client->abort();
+        }
+    });
+    connect(healthMonitor, &LinkHealthMonitor::healthUpdated, this, &WsPortalClient::linkHealthUpdated);
+
+    // Setup reconnect timer, the portal might be changed while waiting
+    connect(reconnectTimer, &QTimer::timeout, [this]() {
+        auto portalId = apiClient->getSettings()->getWsPortalId();
+        if (status != WS_PORTAL_STATUS_INACTIVE && !portalId.isEmpty() && portalId != "none") {
+            open(portalId);
         }
     });
-    intervalTimer->setInterval(INTERVAL_INTERVAL_MSECS);
-    intervalTimer->start();
 
     // obs-websocket doesn't broadcast high-volume events unless having native WebSocket connections
     // so we create dedicated event handler for WsPortal links.
@@ -104,7 +122,7 @@ void WsPortalClient::createWsSocket()
         client, SIGNAL(binaryMessageReceived(const QByteArray &)), this,
         SLOT(onBinaryMessageReceived(const QByteArray &))
     );
-    connect(client, SIGNAL(pong(quint64, const QByteArray &)), this, SLOT(onPong(quint64, const QByteArray &)));
+    healthMonitor->attach(client);
 
     API_LOG("WebSocket created for the portal: %s", qUtf8Printable(wsPortal.getName()));
 }
@@ -115,6 +133,7 @@ void WsPortalClient::destroyWsSocket()
         return;
     }
 
+    healthMonitor->detach();
     client->disconnect(this);
     client->close();
     client->deleteLater();
@@ -165,9 +184,11 @@ void WsPortalClient::start()
 
     status = WS_PORTAL_STATUS_ACTIVE;
     reconnectCount = 0;
+    reconnectBackoff.reset();
     open(portalId);
 
     WsPortalEventHandler::getInstance()->subscribe(wsPortal.getEventSubscriptions());
+    updateEventSubscriptions();
 }
 
 void WsPortalClient::stop()
@@ -177,6 +198,8 @@ void WsPortalClient::stop()
     }
 
     status = WS_PORTAL_STATUS_INACTIVE;
+    updateEventSubscriptions();
+    reconnectTimer->stop();
     destroyWsSocket();
 
     if (!wsPortal.isEmpty()) {
@@ -214,6 +237,32 @@ void WsPortalClient::onWsPortalsReady(const WsPortalArray &portals)
     if (!wsPortal.isEmpty() && status == WS_PORTAL_STATUS_INACTIVE) {
         // Start when not started
         start();
+    } else {
+        updateEventSubscriptions();
+    }
+}
+
+void WsPortalClient::onWsPortalChanged(const QString &id, const WsPortal &portal)
+{
+    if (id != apiClient->getSettings()->getWsPortalId()) {
+        return;
+    }
+
+    wsPortal = portal;
+
+    if (status == WS_PORTAL_STATUS_INACTIVE) {
+        // Start when not started
+        start();
+    } else {
+        updateEventSubscriptions();
+    }
+}
+
+void WsPortalClient::onWsPortalRemoved(const QString &id)
+{
+    if (id == wsPortal.getId()) {
+        wsPortal = WsPortal();
+        updateEventSubscriptions();
     }
 }
 
@@ -227,22 +276,19 @@ void WsPortalClient::onDisconnected()
 {
     auto portalId = apiClient->getSettings()->getWsPortalId();
     if (status != WS_PORTAL_STATUS_INACTIVE && !portalId.isEmpty() && portalId != "none") {
-        API_LOG("Reconnecting");
+        // Avoid tight reconnect loop during server outage
+        auto delay = reconnectBackoff.next();
+        API_LOG("Reconnecting in %d ms", delay);
         reconnectCount++;
-        open(portalId);
+        reconnectTimer->start(delay);
         emit reconnecting();
     }
 }
 
-void WsPortalClient::onPong(quint64 elapsedTime, const QByteArray &)
-{
-    UNUSED_PARAMETER(elapsedTime);
-    API_LOG("Pong received: %llu", elapsedTime);
-}
-
 void WsPortalClient::onTextMessageReceived(const QString &message)
 {
     if (message == "ready") {
+        reconnectBackoff.reset();
         emit ready(reconnectCount > 0);
     }
 }
@@ -366,38 +412,34 @@ void WsPortalClient::sendMessage(const QString &connectionId, int opcode, const
     );
 }
 
-void WsPortalClient::sendEvent(uint64_t requiredIntent, const char *eventType, const char *eventData)
+// Filter out events with portal's event subscriptions on the event handler
+void WsPortalClient::updateEventSubscriptions()
 {
-    if (status != WS_PORTAL_STATUS_ACTIVE) {
-        return;
+    uint64_t eventSubscriptions = 0;
+    if (status == WS_PORTAL_STATUS_ACTIVE && !wsPortal.isEmpty()) {
+        // Default subscriptions is "All" (But high volume events are excluded)
+        eventSubscriptions =
+            (wsPortal["event_subscriptions"].isUndefined() || wsPortal["event_subscriptions"].isNull())
+                ? 0x7FF
+                : (uint64_t)wsPortal.getEventSubscriptions();
     }
 
-    // Filter out events with portal's event subscriptions
-    // Default subscriptions is "All" (But high volume events are excluded)
-    auto eventSubscriptions = (wsPortal["event_subscription"].isUndefined() || wsPortal["event_subscriptions"].isNull())
-                                  ? (int)0x7FF
-                                  : wsPortal.getEventSubscriptions();
-    if (!(requiredIntent & eventSubscriptions)) {
+    WsPortalEventHandler::getInstance()->setEventSubscriptions(onOBSWebSocketEvent, this, eventSubscriptions);
+}
+
+// The message has been serialized by the event handler
+void WsPortalClient::sendEvent(const QByteArray &message)
+{
+    if (status != WS_PORTAL_STATUS_ACTIVE) {
         return;
     }
 
-    json data = {{"eventType", eventType}, {"eventIntent", (int)requiredIntent}, {"eventData", json::parse(eventData)}};
-    json body = {{"op", 5}, {"d", data}};
-    // The body is stored in msgpack encoded binary
-    json message = {{"body", json::to_msgpack(body)}};
-
-    auto raw = json::to_msgpack(message);
     // Called in proper thread
-    QMetaObject::invokeMethod(
-        this, "send", Qt::QueuedConnection,
-        Q_ARG(QByteArray, QByteArray(reinterpret_cast<const char *>(raw.data()), raw.size()))
-    );
+    QMetaObject::invokeMethod(this, "send", Qt::QueuedConnection, Q_ARG(QByteArray, message));
 }
 
-void WsPortalClient::onOBSWebSocketEvent(
-    uint64_t requiredIntent, const char *eventType, const char *eventData, void *privData
-)
+void WsPortalClient::onOBSWebSocketEvent(const QByteArray &message, void *privData)
 {
     auto controller = static_cast<WsPortalClient *>(privData);
-    controller->sendEvent(requiredIntent, eventType, eventData);
+    controller->sendEvent(message);
 }
@@ -28,6 +28,8 @@ using json = nlohmann::json;
 
 #include "../schema.hpp"
 #include "../utils.hpp"
+#include "../reconnect-backoff.hpp"
+#include "../link-health-monitor.hpp"
 
 using OBSWebSocketRequestResponse = OBSPtr<obs_websocket_request_response *, obs_websocket_request_response_free>;
 
@@ -45,15 +47,17 @@ class WsPortalClient : public QObject {
     SRCLinkApiClient *apiClient;
     WsPortalStatus status;
     int reconnectCount;
+    ReconnectBackoff reconnectBackoff;
+    QTimer *reconnectTimer;
     WsPortal wsPortal;
-    QTimer *intervalTimer;
+    LinkHealthMonitor *healthMonitor;
 
     json processRequest(const json &request);
     void sendMessage(const QString &connectionId, int opcode, const json &data);
-    void sendEvent(uint64_t requiredIntent, const char *eventType, const char *eventData);
+    void sendEvent(const QByteArray &message);
+    void updateEventSubscriptions();
 
-    static void
-    onOBSWebSocketEvent(uint64_t requiredIntent, const char *eventType, const char *eventData, void *privData);
+    static void onOBSWebSocketEvent(const QByteArray &message, void *privData);
 
     void createWsSocket();
     void destroyWsSocket();
@@ -64,14 +68,16 @@ signals:
     void ready(bool reconect);
     void disconnected();
     void reconnecting();
+    void linkHealthUpdated(const LinkHealth &health);
 
 private slots:
     void onApiClientReady(bool reconnect);
     void onWsPortalsReady(const WsPortalArray &portals);
+    void onWsPortalChanged(const QString &id, const WsPortal &portal);
+    void onWsPortalRemoved(const QString &id);
     void onLogoutSucceeded();
     void onConnected();
     void onDisconnected();
-    void onPong(quint64 elapsedTime, const QByteArray &payload);
     void onTextMessageReceived(const QString &message);
     void onBinaryMessageReceived(const QByteArray &message);
     void send(const QByteArray &message);
@@ -82,6 +88,7 @@ public:
 
 public slots:
     inline bool getStatus() const { return status; }
+    inline const LinkHealth getLinkHealth() const { return healthMonitor->getHealth(); }
     void start();
     void stop();
     void restart();
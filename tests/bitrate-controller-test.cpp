@@ -0,0 +1,202 @@
+/*
+SRC-Link
+Copyright (C) 2024 OPENSPHERE Inc. info@opensphere.co.jp
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+// Decisions of AdaptiveBitrateController against synthetic 1 s ticks of output counters.
+
+#include <cstdio>
+
+#include "../src/outputs/bitrate-controller.hpp"
+
+#define TICK_NSECS 1000000000ULL
+#define FRAMES_PER_TICK 30
+
+static int failures = 0;
+
+#define CHECK_EQ(actual, expected)                                                                          \
+    do {                                                                                                    \
+        auto _actual = (actual);                                                                            \
+        auto _expected = (expected);                                                                        \
+        if (_actual != _expected) {                                                                         \
+            fprintf(stderr, "%s:%d: %s == %d, expected %d\n", __FILE__, __LINE__, #actual, _actual, _expected); \
+            failures++;                                                                                     \
+        }                                                                                                   \
+    } while (0)
+
+// Cumulative counters of a fake streaming output
+class FakeOutput {
+    AdaptiveBitrateController &controller;
+    int totalFrames;
+    int droppedFrames;
+    uint64_t bytesSent;
+    uint64_t timestamp;
+
+public:
+    explicit FakeOutput(AdaptiveBitrateController &_controller)
+        : controller(_controller),
+          totalFrames(0),
+          droppedFrames(0),
+          bytesSent(0),
+          timestamp(TICK_NSECS)
+    {
+        // Baseline sample
+        controller.update(totalFrames, droppedFrames, bytesSent, 0.0, timestamp);
+    }
+
+    // Advances one tick, throughput in kbps
+    int tick(int dropped, int throughput, double congestion = 0.0)
+    {
+        totalFrames += FRAMES_PER_TICK;
+        droppedFrames += dropped;
+        bytesSent += (uint64_t)throughput * 1000 / 8;
+        timestamp += TICK_NSECS;
+        return controller.update(totalFrames, droppedFrames, bytesSent, congestion, timestamp);
+    }
+
+    int healthy(int ticks)
+    {
+        auto bitrate = controller.getBitrate();
+        for (int i = 0; i < ticks; i++) {
+            bitrate = tick(0, bitrate);
+        }
+        return bitrate;
+    }
+};
+
+static void testDropBurstDecreases()
+{
+    AdaptiveBitrateController controller;
+    controller.reset(1000, 6000, 6000);
+    FakeOutput output(controller);
+
+    // 1 of 30 frames (3.3%) is over the 2% threshold
+    CHECK_EQ(output.tick(1, 6000), 4500);
+}
+
+static void testCongestionDecreases()
+{
+    AdaptiveBitrateController controller;
+    controller.reset(1000, 6000, 6000);
+    FakeOutput output(controller);
+
+    CHECK_EQ(output.tick(0, 6000, 0.5), 6000);
+    CHECK_EQ(output.tick(0, 6000, 0.6), 4500);
+}
+
+static void testThroughputCap()
+{
+    AdaptiveBitrateController controller;
+    controller.reset(1000, 6000, 6000);
+    FakeOutput output(controller);
+
+    // 75% would be 4500 kbps, but only 3000 kbps got through
+    CHECK_EQ(output.tick(5, 3000), 2700);
+}
+
+static void testCooldown()
+{
+    AdaptiveBitrateController controller;
+    controller.reset(500, 6000, 6000);
+    FakeOutput output(controller);
+
+    CHECK_EQ(output.tick(5, 6000), 4500);
+    // Encoder settles for 3 ticks before the next decrease
+    CHECK_EQ(output.tick(5, 6000), 4500);
+    CHECK_EQ(output.tick(5, 6000), 4500);
+    CHECK_EQ(output.tick(5, 6000), 4500);
+    CHECK_EQ(output.tick(5, 6000), 3375);
+}
+
+static void testRecovery()
+{
+    AdaptiveBitrateController controller;
+    controller.reset(1000, 6000, 6000);
+    FakeOutput output(controller);
+
+    CHECK_EQ(output.tick(5, 6000), 4500);
+    CHECK_EQ(output.healthy(4), 4500);
+    // 5th healthy tick steps up by 5% of the ceiling
+    CHECK_EQ(output.healthy(1), 4800);
+    CHECK_EQ(output.healthy(4), 4800);
+    CHECK_EQ(output.healthy(1), 5100);
+
+    // Marginal congestion holds and restarts the healthy count
+    CHECK_EQ(output.healthy(4), 5100);
+    CHECK_EQ(output.tick(0, 5100, 0.2), 5100);
+    CHECK_EQ(output.healthy(4), 5100);
+    CHECK_EQ(output.healthy(1), 5400);
+}
+
+static void testClamps()
+{
+    AdaptiveBitrateController controller;
+
+    // Initial bitrate is clamped into the window
+    controller.reset(1000, 6000, 8000);
+    CHECK_EQ(controller.getBitrate(), 6000);
+    controller.reset(1000, 6000, 500);
+    CHECK_EQ(controller.getBitrate(), 1000);
+
+    // Without a connection minimum, the floor is 25% of the ceiling
+    controller.reset(0, 6000, 6000);
+    CHECK_EQ(controller.getFloorBitrate(), 1500);
+
+    // Never below the floor
+    controller.reset(2000, 6000, 2500);
+    FakeOutput lossy(controller);
+    CHECK_EQ(lossy.tick(5, 100), 2000);
+    for (int i = 0; i < 8; i++) {
+        lossy.tick(5, 100);
+    }
+    CHECK_EQ(controller.getBitrate(), 2000);
+
+    // Never above the ceiling
+    controller.reset(1000, 6000, 5900);
+    FakeOutput healthy(controller);
+    CHECK_EQ(healthy.healthy(5), 6000);
+    CHECK_EQ(healthy.healthy(20), 6000);
+}
+
+static void testRestartTakesBaseline()
+{
+    AdaptiveBitrateController controller;
+    controller.reset(1000, 6000, 6000);
+    FakeOutput output(controller);
+    output.tick(0, 6000);
+
+    // Counters going backwards (output restarted) must not be read as drops
+    CHECK_EQ(controller.update(0, 0, 0, 0.0, 100 * TICK_NSECS), 6000);
+    CHECK_EQ(controller.update(FRAMES_PER_TICK, 0, 750000, 0.0, 101 * TICK_NSECS), 6000);
+}
+
+int main()
+{
+    testDropBurstDecreases();
+    testCongestionDecreases();
+    testThroughputCap();
+    testCooldown();
+    testRecovery();
+    testClamps();
+    testRestartTakesBaseline();
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All checks passed\n");
+    return 0;
+}